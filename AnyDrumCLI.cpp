@@ -0,0 +1,387 @@
+/*
+  ==============================================================================
+
+    AnyDrumCLI.cpp
+
+    A console front end that runs the plugin's own detection and playback
+    over whole files, as fast as the machine allows and several files at a
+    time. The console target adds this file, ProcessorBenchmark.cpp and
+    LatencyHarness.cpp to the plugin's sources, and none of the three may be
+    compiled into the plugin itself.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "PluginProcessor.h"
+#include "ProcessorBenchmark.h"
+#include "LatencyHarness.h"
+
+namespace
+{
+    //==============================================================================
+    struct Options
+    {
+        juce::File sampleSource;
+        juce::File outputFolder;//empty to write each result next to its input
+        int numThreads = juce::SystemStats::getNumCpus();
+        int blockSize = 512;
+        juce::StringPairArray parameterValues;
+        juce::Array<juce::File> inputs;
+
+        juce::File benchmarkResults;//set when running the benchmark instead of processing files
+        juce::File latencyResults;//set when running the latency harness instead of processing files
+        double seconds = 0.0;//0 for each mode's own default
+    };
+
+    void printLine(const juce::String& text)
+    {
+        static juce::CriticalSection outputLock;
+
+        const juce::ScopedLock sl(outputLock);
+        std::cout << text << std::endl;
+    }
+
+    void printUsage()
+    {
+        printLine("usage: AnyDrumCLI --sample <file, folder or .anydrum> [options] input.wav...");
+        printLine("       AnyDrumCLI --benchmark <results.json> [--seconds <n>] [--sample <path>] [--<parameter> <v>...]");
+        printLine("       AnyDrumCLI --latency <results.json> [--seconds <n>] [--<parameter> <v>...]");
+        printLine("");
+        printLine("  --sample <path>      the replacement sample set");
+        printLine("  --out <folder>       where to write results (default: next to each input)");
+        printLine("  --threads <n>        files processed at once (default: one per cpu)");
+        printLine("  --block <n>          block size handed to the processor (default: 512)");
+        printLine("  --<parameter> <v>    any plugin parameter by id, e.g. --threshold 0.4 --detector \"Spectral Flux\"");
+        printLine("");
+        printLine("  --benchmark <file>   time processBlock() over a sweep of block sizes, rates, channels and hit densities");
+        printLine("  --latency <file>     measure detection delay, misses and double triggers on a synthetic drum track");
+        printLine("  --seconds <n>        length of audio for each combination (default: 4 for the benchmark, 30 for latency)");
+        printLine("");
+        printLine("each input is written as <name>_anydrum.wav, with the detection latency trimmed off.");
+    }
+
+    bool parseArguments(const juce::StringArray& args, Options& options, juce::String& error)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            auto arg = args[i];
+
+            if (! arg.startsWith("--"))
+            {
+                options.inputs.add(juce::File::getCurrentWorkingDirectory().getChildFile(arg));
+                continue;
+            }
+
+            if (i + 1 >= args.size())
+            {
+                error = arg + " needs a value";
+                return false;
+            }
+
+            auto name = arg.substring(2);
+            auto value = args[++i];
+
+            if (name == "sample")
+                options.sampleSource = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+            else if (name == "out")
+                options.outputFolder = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+            else if (name == "threads")
+                options.numThreads = juce::jmax(1, value.getIntValue());
+            else if (name == "block")
+                options.blockSize = juce::jlimit(16, 65536, value.getIntValue());
+            else if (name == "benchmark")
+                options.benchmarkResults = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+            else if (name == "latency")
+                options.latencyResults = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+            else if (name == "seconds")
+                options.seconds = juce::jlimit(0.5, 600.0, value.getDoubleValue());
+            else
+                options.parameterValues.set(name, value);
+        }
+
+        //the benchmark and the latency harness bring their own signals, and the benchmark its own sample if none is given
+        if (options.benchmarkResults != juce::File() || options.latencyResults != juce::File())
+        {
+            if (options.sampleSource != juce::File() && ! DrumSampleSet::isLoadableFile(options.sampleSource))
+            {
+                error = "--sample must name an audio file, a folder or a .anydrum manifest";
+                return false;
+            }
+
+            return true;
+        }
+
+        if (! DrumSampleSet::isLoadableFile(options.sampleSource))
+        {
+            error = "--sample must name an audio file, a folder or a .anydrum manifest";
+            return false;
+        }
+
+        if (options.inputs.isEmpty())
+        {
+            error = "no input files given";
+            return false;
+        }
+
+        return true;
+    }
+
+    //==============================================================================
+    class ReplaceJob  : public juce::ThreadPoolJob
+    {
+    public:
+        ReplaceJob(const Options& options, const juce::File& input)
+            : juce::ThreadPoolJob(input.getFileName()), mOptions(options), mInput(input)
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            juce::String report;
+            mSucceeded = process(report);
+
+            printLine(mInput.getFileName() + ": " + report);
+            return jobHasFinished;
+        }
+
+        bool hasSucceeded() const noexcept              { return mSucceeded; }
+        juce::int64 getNumSamples() const noexcept      { return mNumSamples; }
+
+    private:
+        bool process(juce::String& report)
+        {
+            juce::AudioFormatManager formatManager;
+            formatManager.registerBasicFormats();
+
+            std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(mInput));
+
+            if (reader == nullptr)
+            {
+                report = "can't read this file";
+                return false;
+            }
+
+            auto numChannels = static_cast<int>(reader->numChannels);
+            auto sampleRate = reader->sampleRate;
+            auto blockSize = mOptions.blockSize;
+
+            AnyDrum001AudioProcessor processor;
+
+            juce::AudioProcessor::BusesLayout layout;
+            layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+            layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+
+            if (! processor.setBusesLayout(layout))
+            {
+                report = "the processor doesn't support " + juce::String(numChannels) + " channels";
+                return false;
+            }
+
+            //lookahead lines the replacement up with the original, and its delay gets trimmed below
+            processor.setParameterFromText("toggle", "1");
+            processor.setParameterFromText("lookahead", "1");
+
+            for (auto& parameterID : mOptions.parameterValues.getAllKeys())
+            {
+                if (! processor.setParameterFromText(parameterID, mOptions.parameterValues[parameterID]))
+                {
+                    report = "unknown parameter --" + parameterID;
+                    return false;
+                }
+            }
+
+            processor.setNonRealtime(true);
+            processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+            processor.prepareToPlay(sampleRate, blockSize);
+
+            //loaded after prepareToPlay() so the set comes out already at this file's rate
+            processor.currentlyLoadedFile = mOptions.sampleSource;
+
+            if (! processor.loadSampleFileNow())
+            {
+                report = "couldn't load " + mOptions.sampleSource.getFullPathName();
+                return false;
+            }
+
+            auto outputFolder = mOptions.outputFolder != juce::File() ? mOptions.outputFolder : mInput.getParentDirectory();
+            auto outputFile = outputFolder.getChildFile(mInput.getFileNameWithoutExtension() + "_anydrum.wav");
+
+            if (outputFile == mInput || ! outputFolder.createDirectory())
+            {
+                report = "can't write " + outputFile.getFullPathName();
+                return false;
+            }
+
+            outputFile.deleteFile();
+
+            std::unique_ptr<juce::FileOutputStream> stream(outputFile.createOutputStream());
+            std::unique_ptr<juce::AudioFormatWriter> writer;
+
+            if (stream != nullptr)
+            {
+                auto bitsPerSample = reader->usesFloatingPointData ? 32 : (reader->bitsPerSample > 16 ? 24 : 16);
+
+                juce::WavAudioFormat wavFormat;
+                writer.reset(wavFormat.createWriterFor(stream.get(), sampleRate, static_cast<unsigned int>(numChannels), bitsPerSample, {}, 0));
+            }
+
+            if (writer == nullptr)
+            {
+                report = "can't write " + outputFile.getFullPathName();
+                return false;
+            }
+
+            stream.release();//the writer owns it now
+
+            auto totalSamples = reader->lengthInSamples;
+            juce::int64 numToTrim = processor.getLatencySamples();
+            juce::int64 readPosition = 0;
+            juce::int64 numWritten = 0;
+            juce::int64 processingTicks = 0;
+
+            juce::AudioBuffer<float> buffer(numChannels, blockSize);
+            juce::MidiBuffer midiMessages;
+
+            auto startTicks = juce::Time::getHighResolutionTicks();
+
+            while (numWritten < totalSamples)
+            {
+                //reading past the end gives silence, which flushes the lookahead delay out
+                reader->read(&buffer, 0, blockSize, readPosition, true, true);
+                readPosition += blockSize;
+
+                midiMessages.clear();
+
+                auto blockStart = juce::Time::getHighResolutionTicks();
+                processor.processBlock(buffer, midiMessages);
+                processingTicks += juce::Time::getHighResolutionTicks() - blockStart;
+
+                auto firstToWrite = static_cast<int>(juce::jmin(numToTrim, static_cast<juce::int64>(blockSize)));
+                numToTrim -= firstToWrite;
+
+                auto numToWrite = static_cast<int>(juce::jmin(static_cast<juce::int64>(blockSize - firstToWrite), totalSamples - numWritten));
+
+                if (numToWrite > 0)
+                {
+                    writer->writeFromAudioSampleBuffer(buffer, firstToWrite, numToWrite);
+                    numWritten += numToWrite;
+                }
+            }
+
+            processor.releaseResources();
+
+            auto totalSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+            auto processingSeconds = juce::Time::highResolutionTicksToSeconds(processingTicks);
+
+            mNumSamples = totalSamples;
+
+            report = juce::String(totalSamples) + " samples in " + juce::String(totalSeconds, 2) + "s, "
+                   + juce::String(totalSamples / juce::jmax(totalSeconds, 1.0e-9), 0) + " samples/sec ("
+                   + juce::String(totalSamples / juce::jmax(processingSeconds, 1.0e-9), 0) + " in processBlock), "
+                   + juce::String(totalSamples / sampleRate / juce::jmax(totalSeconds, 1.0e-9), 1) + "x real time";
+
+            return true;
+        }
+
+        const Options& mOptions;
+        juce::File mInput;
+        bool mSucceeded = false;
+        juce::int64 mNumSamples = 0;
+
+        //==============================================================================
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReplaceJob)
+    };
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    //the processor's async updaters want a message manager to exist, even though nothing dispatches it here
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add(juce::CharPointer_UTF8(argv[i]));
+
+    Options options;
+    juce::String error;
+
+    if (args.isEmpty() || ! parseArguments(args, options, error))
+    {
+        if (error.isNotEmpty())
+            printLine("error: " + error);
+
+        printUsage();
+        return 1;
+    }
+
+    if (options.benchmarkResults != juce::File())
+    {
+        ProcessorBenchmark::Settings settings;
+        settings.sampleSource = options.sampleSource;
+        settings.parameterValues = options.parameterValues;
+
+        if (options.seconds > 0.0)
+            settings.secondsPerRun = options.seconds;
+
+        //one run at a time, so the timings aren't fighting each other for cores
+        if (! ProcessorBenchmark(settings).run(options.benchmarkResults))
+        {
+            printLine("error: the benchmark couldn't run, or its results couldn't be written");
+            return 1;
+        }
+
+        printLine("results written to " + options.benchmarkResults.getFullPathName());
+        return 0;
+    }
+
+    if (options.latencyResults != juce::File())
+    {
+        LatencyHarness::Settings settings;
+        settings.parameterValues = options.parameterValues;
+
+        if (options.seconds > 0.0)
+            settings.secondsPerRun = options.seconds;
+
+        if (! LatencyHarness(settings).run(options.latencyResults))
+        {
+            printLine("error: the latency harness couldn't run, its results couldn't be written, or lookahead hits missed their onsets");
+            return 1;
+        }
+
+        printLine("results written to " + options.latencyResults.getFullPathName());
+        return 0;
+    }
+
+    //declared first so the pool is gone before the jobs are
+    juce::OwnedArray<ReplaceJob> jobs;
+    juce::ThreadPool pool(juce::jmin(options.numThreads, options.inputs.size()));
+
+    auto startTicks = juce::Time::getHighResolutionTicks();
+
+    for (auto& input : options.inputs)
+        pool.addJob(jobs.add(new ReplaceJob(options, input)), false);
+
+    int numFailed = 0;
+    juce::int64 totalSamples = 0;
+
+    for (auto* job : jobs)
+    {
+        pool.waitForJobToFinish(job, -1);
+
+        if (job->hasSucceeded())
+            totalSamples += job->getNumSamples();
+        else
+            ++numFailed;
+    }
+
+    auto totalSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    printLine(juce::String(jobs.size() - numFailed) + " of " + juce::String(jobs.size()) + " files done in "
+              + juce::String(totalSeconds, 2) + "s, " + juce::String(totalSamples / juce::jmax(totalSeconds, 1.0e-9), 0) + " samples/sec overall");
+
+    return numFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    DiagnosticsPanel.cpp
+
+  ==============================================================================
+*/
+
+#include "DiagnosticsPanel.h"
+
+//==============================================================================
+DiagnosticsPanel::DiagnosticsPanel(ProcessorTelemetry& telemetry)
+    : mTelemetry(telemetry)
+{
+    mText.setMultiLine(true, false);
+    mText.setReadOnly(true);
+    mText.setCaretVisible(false);
+    mText.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 13.0f, juce::Font::plain));
+    mText.setColour(juce::TextEditor::backgroundColourId, juce::Colours::transparentBlack);
+    mText.setColour(juce::TextEditor::outlineColourId, juce::Colours::transparentBlack);
+    mText.setColour(juce::TextEditor::textColourId, juce::Colour(242u, 242u, 242u));
+    addAndMakeVisible(&mText);
+
+    addAndMakeVisible(&mDumpButton);
+    mDumpButton.onClick = [this]
+    {
+        dumpButtonClicked();
+    };
+
+    addAndMakeVisible(&mResetButton);
+    mResetButton.onClick = [this]
+    {
+        mTelemetry.requestReset();
+    };
+}
+
+DiagnosticsPanel::~DiagnosticsPanel()
+{
+    stopTimer();
+}
+
+//==============================================================================
+void DiagnosticsPanel::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black.withAlpha(0.85f));
+
+    g.setColour(juce::Colour(169u, 169u, 169u));
+    g.drawRect(getLocalBounds());
+}
+
+void DiagnosticsPanel::resized()
+{
+    auto bounds = getLocalBounds().reduced(6);
+    auto buttonRow = bounds.removeFromBottom(24);
+
+    mResetButton.setBounds(buttonRow.removeFromRight(70));
+    buttonRow.removeFromRight(6);
+    mDumpButton.setBounds(buttonRow.removeFromRight(70));
+
+    mText.setBounds(bounds);
+}
+
+void DiagnosticsPanel::visibilityChanged()
+{
+    //nothing is polled while the panel is closed
+    if (isVisible())
+    {
+        refresh();
+        startTimerHz(4);
+    }
+    else
+    {
+        stopTimer();
+    }
+}
+
+void DiagnosticsPanel::timerCallback()
+{
+    refresh();
+}
+
+void DiagnosticsPanel::refresh()
+{
+    mText.setText(mTelemetry.getSnapshot().toText(), false);
+}
+
+void DiagnosticsPanel::dumpButtonClicked()
+{
+    juce::FileChooser chooser("Save diagnostics", juce::File::getSpecialLocation(juce::File::userDesktopDirectory).getChildFile("AnyDrum diagnostics.txt"), "*.txt", true, false);
+
+    if (chooser.browseForFileToSave(true))
+        if (! mTelemetry.dumpToFile(chooser.getResult()))
+            juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Save diagnostics", "Couldn't write " + chooser.getResult().getFullPathName());
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    DiagnosticsPanel.h
+
+    Shows the processor's telemetry over the graph area, refreshed a few
+    times a second while it's open, with buttons to reset the counters or
+    dump them to a text file.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ProcessorTelemetry.h"
+
+//==============================================================================
+/**
+*/
+class DiagnosticsPanel  : public juce::Component,
+                          private juce::Timer
+{
+public:
+    explicit DiagnosticsPanel(ProcessorTelemetry& telemetry);
+    ~DiagnosticsPanel() override;
+
+    //==============================================================================
+    void paint(juce::Graphics&) override;
+    void resized() override;
+    void visibilityChanged() override;
+
+private:
+    //==============================================================================
+    void timerCallback() override;
+    void refresh();
+    void dumpButtonClicked();
+
+    ProcessorTelemetry& mTelemetry;
+
+    juce::TextEditor mText;
+    juce::TextButton mDumpButton{ "Dump..." };
+    juce::TextButton mResetButton{ "Reset" };
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DiagnosticsPanel)
+};
@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    DrumKit.cpp
+
+  ==============================================================================
+*/
+
+#include "DrumKit.h"
+
+//==============================================================================
+DrumKit::Ptr DrumKit::withSets(const std::array<DrumSampleSet::Ptr, numSlots>& newSets) const
+{
+    Ptr kit(new DrumKit());
+
+    for (size_t slot = 0; slot < mSets.size(); ++slot)
+        kit->mSets[slot] = newSets[slot] != nullptr ? newSets[slot] : mSets[slot];
+
+    return kit;
+}
+
+DrumSampleSet* DrumKit::getSet(int slot) const noexcept
+{
+    if (! juce::isPositiveAndBelow(slot, numSlots))
+        return nullptr;
+
+    return mSets[static_cast<size_t>(slot)].get();
+}
+
+int DrumKit::findSlotForChannel(int channel) const noexcept
+{
+    if (getSet(channel) != nullptr)
+        return channel;
+
+    return getSet(0) != nullptr ? 0 : -1;
+}
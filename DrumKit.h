@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    DrumKit.h
+
+    One sample set per input channel, so a single instance can replace a
+    whole multitracked kit. A kit is never changed once it's been handed to
+    the audio thread; loading into a slot publishes a new kit instead.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DrumSampleSet.h"
+
+//==============================================================================
+/**
+*/
+class DrumKit  : public juce::ReferenceCountedObject
+{
+public:
+    //==============================================================================
+    using Ptr = juce::ReferenceCountedObjectPtr<DrumKit>;
+
+    static constexpr int numSlots = 8;
+
+    DrumKit() = default;
+
+    //a copy of this kit with the given slots replaced. null entries keep what's already there.
+    Ptr withSets(const std::array<DrumSampleSet::Ptr, numSlots>& newSets) const;
+
+    //==============================================================================
+    DrumSampleSet* getSet(int slot) const noexcept;
+
+    //the slot that plays for a channel: its own, or the first slot if that one is empty or the hit was linked.
+    //returns -1 if neither has anything loaded.
+    int findSlotForChannel(int channel) const noexcept;
+
+private:
+    //==============================================================================
+    std::array<DrumSampleSet::Ptr, numSlots> mSets;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DrumKit)
+};
@@ -0,0 +1,233 @@
+/*
+  ==============================================================================
+
+    DrumSample.cpp
+
+  ==============================================================================
+*/
+
+#include "DrumSample.h"
+
+namespace
+{
+    template <typename InterpolatorType>
+    void resampleChannel(const float* input, int numInputSamples, float* output, int numOutputSamples, double speedRatio)
+    {
+        InterpolatorType interpolator;
+
+        //the interpolator's output trails its input, so run it on past the end and drop the lead-in
+        auto latency = static_cast<double>(interpolator.getBaseLatency());
+        auto numToDrop = juce::roundToInt(latency / speedRatio);
+        auto numToProduce = numOutputSamples + numToDrop;
+
+        //zero padding so it has enough input to flush the tail out
+        auto numPadded = static_cast<int>(std::ceil((numToProduce + 1) * speedRatio + latency)) + 4;
+        std::vector<float> padded(static_cast<size_t>(juce::jmax(numPadded, numInputSamples)), 0.0f);
+        std::copy(input, input + numInputSamples, padded.begin());
+
+        std::vector<float> produced(static_cast<size_t>(numToProduce));
+        interpolator.process(speedRatio, padded.data(), produced.data(), numToProduce);
+
+        std::copy(produced.begin() + numToDrop, produced.end(), output);
+    }
+}
+
+//==============================================================================
+DrumSample::DrumSample(juce::AudioBuffer<float>&& decodedAudio, double sampleRate, double sourceSampleRate,
+                       const juce::File& sourceFile, const juce::String& contentHash)
+    : mBuffer(std::move(decodedAudio)), mSampleRate(sampleRate), mSourceSampleRate(sourceSampleRate), mFile(sourceFile), mContentHash(contentHash)
+{
+    analyse();
+}
+
+DrumSample::Ptr DrumSample::loadFromFile(juce::AudioFormatManager& formatManager, const juce::File& file,
+                                         double playbackRate, Resampler resampler,
+                                         juce::MemoryBlock* losslessData, const juce::String& contentHash)
+{
+    return loadFromReader(formatManager.createReaderFor(file), file, contentHash, playbackRate, resampler, losslessData);
+}
+
+DrumSample::Ptr DrumSample::loadFromLosslessData(const juce::MemoryBlock& data, const juce::String& contentHash, const juce::File& sourceFile,
+                                                 double playbackRate, Resampler resampler)
+{
+    juce::FlacAudioFormat flacFormat;
+    auto* reader = flacFormat.createReaderFor(new juce::MemoryInputStream(data, false), true);
+
+    //float sources are embedded as wav
+    if (reader == nullptr)
+    {
+        juce::WavAudioFormat wavFormat;
+        reader = wavFormat.createReaderFor(new juce::MemoryInputStream(data, false), true);
+    }
+
+    return loadFromReader(reader, sourceFile, contentHash, playbackRate, resampler);
+}
+
+DrumSample::Ptr DrumSample::loadFromReader(juce::AudioFormatReader* readerToUse, const juce::File& sourceFile, const juce::String& contentHash,
+                                           double playbackRate, Resampler resampler, juce::MemoryBlock* losslessData)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(readerToUse);
+
+    if (reader == nullptr)
+        return nullptr;
+
+    //the whole hit has to fit into a single buffer
+    if (reader->lengthInSamples <= 0 || reader->lengthInSamples > std::numeric_limits<int>::max())
+        return nullptr;
+
+    auto numChannels = static_cast<int>(reader->numChannels);
+    auto numSamples = static_cast<int>(reader->lengthInSamples);
+
+    juce::AudioBuffer<float> decoded(numChannels, numSamples);
+
+    if (! reader->read(&decoded, 0, numSamples, 0, true, true))
+        return nullptr;
+
+    auto sourceRate = reader->sampleRate;
+    auto hash = contentHash;
+
+    //encoded from exactly what was decoded, so a session embeds the audio that's playing even if the file changes later.
+    //a sample that can't be encoded still plays, it just can't be embedded.
+    if (losslessData != nullptr)
+    {
+        *losslessData = encodeLossless(decoded, sourceRate, reader->bitsPerSample, reader->usesFloatingPointData);
+        hash = losslessData->isEmpty() ? juce::String() : hashData(*losslessData);
+    }
+
+    if (playbackRate <= 0.0 || sourceRate <= 0.0 || playbackRate == sourceRate)
+        return new DrumSample(std::move(decoded), sourceRate, sourceRate, sourceFile, hash);
+
+    return new DrumSample(resample(decoded, sourceRate, playbackRate, resampler), playbackRate, sourceRate, sourceFile, hash);
+}
+
+juce::MemoryBlock DrumSample::encodeLossless(const juce::AudioBuffer<float>& audio, double sampleRate,
+                                             unsigned int bitsPerSample, bool usesFloatingPointData)
+{
+    juce::MemoryBlock data;
+    auto* stream = new juce::MemoryOutputStream(data, false);
+    auto numChannels = static_cast<unsigned int>(audio.getNumChannels());
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+
+    //integer audio decodes to floats flac can hold exactly at the same depth (8 bit goes up to 16, flac's smallest).
+    //anything deeper or already float would be quantised, and float could also clip, so it's kept as float.
+    if (! usesFloatingPointData && bitsPerSample <= 24)
+    {
+        juce::FlacAudioFormat flacFormat;
+        writer.reset(flacFormat.createWriterFor(stream, sampleRate, numChannels, bitsPerSample <= 16 ? 16 : 24, {}, 0));
+    }
+    else
+    {
+        juce::WavAudioFormat wavFormat;
+        writer.reset(wavFormat.createWriterFor(stream, sampleRate, numChannels, 32, {}, 0));
+    }
+
+    if (writer == nullptr)
+    {
+        delete stream;
+        return {};
+    }
+
+    if (! writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples()))
+        return {};
+
+    writer.reset();//flushes and closes the stream, trimming the block to what was written
+    return data;
+}
+
+juce::String DrumSample::hashData(const juce::MemoryBlock& data)
+{
+    auto hash = static_cast<juce::uint64>(14695981039346656037ull);
+    auto* bytes = static_cast<const juce::uint8*>(data.getData());
+
+    for (size_t i = 0; i < data.getSize(); ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return juce::String::toHexString(static_cast<juce::int64>(hash)).paddedLeft('0', 16);
+}
+
+juce::AudioBuffer<float> DrumSample::resample(const juce::AudioBuffer<float>& source, double sourceRate, double targetRate, Resampler resampler)
+{
+    auto speedRatio = sourceRate / targetRate;
+    auto numInputSamples = source.getNumSamples();
+    auto numOutputSamples = juce::jmax(1, static_cast<int>(std::ceil(numInputSamples / speedRatio)));
+
+    juce::AudioBuffer<float> result(source.getNumChannels(), numOutputSamples);
+
+    for (int channel = 0; channel < source.getNumChannels(); ++channel)
+    {
+        auto* in = source.getReadPointer(channel);
+        auto* out = result.getWritePointer(channel);
+
+        switch (resampler)
+        {
+            case Resampler::linear:         resampleChannel<juce::Interpolators::Linear>(in, numInputSamples, out, numOutputSamples, speedRatio); break;
+            case Resampler::lagrange:       resampleChannel<juce::Interpolators::Lagrange>(in, numInputSamples, out, numOutputSamples, speedRatio); break;
+            case Resampler::windowedSinc:
+            default:                        resampleChannel<juce::Interpolators::WindowedSinc>(in, numInputSamples, out, numOutputSamples, speedRatio); break;
+        }
+    }
+
+    return result;
+}
+
+int DrumSample::getStartPosition(double startSeconds) const noexcept
+{
+    if (startSeconds < 0.0)
+        return mOnsetSample;
+
+    return juce::jlimit(0, juce::jmax(0, getNumSamples() - 1), static_cast<int>(startSeconds * mSampleRate));
+}
+
+void DrumSample::analyse() noexcept
+{
+    auto numSamples = mBuffer.getNumSamples();
+    auto peak = 0.0f;
+
+    for (int channel = 0; channel < mBuffer.getNumChannels(); ++channel)
+    {
+        auto* data = mBuffer.getReadPointer(channel);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto level = std::abs(data[i]);
+
+            if (level > peak)
+            {
+                peak = level;
+                mPeakSample = i;
+            }
+        }
+    }
+
+    //a silent sample has nothing to trim
+    if (peak <= 0.0f)
+        return;
+
+    //the first frame, on any channel, that comes close enough to the peak. the peak itself always does.
+    auto threshold = peak * juce::Decibels::decibelsToGain(onsetThresholdDecibels);
+    auto firstLoudSample = mPeakSample;
+
+    for (int channel = 0; channel < mBuffer.getNumChannels(); ++channel)
+    {
+        auto* data = mBuffer.getReadPointer(channel);
+
+        for (int i = 0; i < firstLoudSample; ++i)
+        {
+            if (std::abs(data[i]) >= threshold)
+            {
+                firstLoudSample = i;
+                break;
+            }
+        }
+    }
+
+    mOnsetSample = juce::jmax(0, firstLoudSample - static_cast<int>(onsetPreRollSeconds * mSampleRate));
+}
+
+size_t DrumSample::getMemoryUsage() const noexcept
+{
+    return static_cast<size_t>(mBuffer.getNumChannels()) * static_cast<size_t>(mBuffer.getNumSamples()) * sizeof(float);
+}
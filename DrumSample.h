@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    DrumSample.h
+
+    A replacement drum hit, decoded once into memory so that playback never
+    has to touch a file reader on the audio thread. The hit is converted to
+    the host rate at load time, so playing it back is a straight copy. Its
+    onset and peak are found then as well, so playback can skip any silence
+    or pre-roll in front of the hit.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class DrumSample  : public juce::ReferenceCountedObject
+{
+public:
+    //==============================================================================
+    using Ptr = juce::ReferenceCountedObjectPtr<DrumSample>;
+
+    enum class Resampler
+    {
+        linear = 0,
+        lagrange,
+        windowedSinc
+    };
+
+    DrumSample(juce::AudioBuffer<float>&& decodedAudio, double sampleRate, double sourceSampleRate,
+               const juce::File& sourceFile, const juce::String& contentHash = {});
+
+    //decodes the whole file into one contiguous float buffer, converted to playbackRate
+    //(or left at the file's own rate if playbackRate is 0). returns nullptr if the file can't be read.
+    //if losslessData isn't null, the decoded audio is also encoded into it for embedding, and its hash
+    //becomes the sample's content hash. otherwise the sample takes contentHash.
+    static Ptr loadFromFile(juce::AudioFormatManager& formatManager, const juce::File& file,
+                            double playbackRate = 0.0, Resampler resampler = Resampler::windowedSinc,
+                            juce::MemoryBlock* losslessData = nullptr, const juce::String& contentHash = {});
+
+    //the same, from audio embedded in a saved session by encodeLossless(). sourceFile is only kept as a name.
+    static Ptr loadFromLosslessData(const juce::MemoryBlock& data, const juce::String& contentHash, const juce::File& sourceFile,
+                                    double playbackRate = 0.0, Resampler resampler = Resampler::windowedSinc);
+
+    //audio at its source rate, in a form that decodes back to exactly the same floats: flac at the source's
+    //own depth for integer sources up to 24 bits, 32 bit float wav for anything else. empty if it can't be written.
+    static juce::MemoryBlock encodeLossless(const juce::AudioBuffer<float>& audio, double sampleRate,
+                                            unsigned int bitsPerSample, bool usesFloatingPointData);
+
+    //64 bit FNV-1a of the data, in hex, so identical audio gets the same key in every session
+    static juce::String hashData(const juce::MemoryBlock& data);
+
+    //converts every channel from one rate to another, compensating for the resampler's latency so the onset stays put
+    static juce::AudioBuffer<float> resample(const juce::AudioBuffer<float>& source, double sourceRate, double targetRate, Resampler resampler);
+
+    //==============================================================================
+    //read-only, since one sample can be shared by every instance that loaded the same file
+    const juce::AudioBuffer<float>& getBuffer() const noexcept  { return mBuffer; }
+
+    int getNumChannels() const noexcept                         { return mBuffer.getNumChannels(); }
+    int getNumSamples() const noexcept                          { return mBuffer.getNumSamples(); }
+    double getSampleRate() const noexcept                       { return mSampleRate; }
+    double getSourceSampleRate() const noexcept                 { return mSourceSampleRate; }
+    const juce::File& getFile() const noexcept                  { return mFile; }
+
+    //where the hit starts, a little before it first comes within onsetThresholdDecibels of its peak,
+    //and where that peak is. both found once, when the sample is made.
+    int getOnsetSample() const noexcept                         { return mOnsetSample; }
+    int getPeakSample() const noexcept                          { return mPeakSample; }
+
+    //where playback begins: the onset, or startSeconds in if that isn't negative
+    int getStartPosition(double startSeconds) const noexcept;
+
+    static constexpr float onsetThresholdDecibels = -36.0f;
+    static constexpr double onsetPreRollSeconds = 0.0005;//keeps the very front of the attack
+
+    //the hash of the lossless copy the sample was restored from or encoded alongside. empty if there isn't one.
+    const juce::String& getContentHash() const noexcept         { return mContentHash; }
+
+    size_t getMemoryUsage() const noexcept;
+
+private:
+    //==============================================================================
+    static Ptr loadFromReader(juce::AudioFormatReader* reader, const juce::File& sourceFile, const juce::String& contentHash,
+                              double playbackRate, Resampler resampler, juce::MemoryBlock* losslessData = nullptr);
+
+    void analyse() noexcept;
+
+    juce::AudioBuffer<float> mBuffer;
+    double mSampleRate = 44100.0;
+    double mSourceSampleRate = 44100.0;
+    juce::File mFile;
+    juce::String mContentHash;
+    int mOnsetSample = 0;
+    int mPeakSample = 0;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DrumSample)
+};
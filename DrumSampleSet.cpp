@@ -0,0 +1,289 @@
+/*
+  ==============================================================================
+
+    DrumSampleSet.cpp
+
+  ==============================================================================
+*/
+
+#include "DrumSampleSet.h"
+
+//==============================================================================
+namespace
+{
+    const juce::String audioFileWildcard("*.wav;*.mp3;*.aif;*.aiff");
+    const juce::String manifestExtension(".anydrum");
+
+    bool isAudioFile(const juce::File& file)
+    {
+        return file.hasFileExtension("wav;mp3;aif;aiff");
+    }
+}
+
+//==============================================================================
+DrumSampleSet::DrumSampleSet(const juce::File& source, double playbackRate, DrumSample::Resampler resampler)
+    : mSource(source), mPlaybackRate(playbackRate), mResampler(resampler)
+{
+}
+
+bool DrumSampleSet::isLoadableFile(const juce::File& file)
+{
+    return file.isDirectory() || isAudioFile(file) || file.hasFileExtension(manifestExtension);
+}
+
+DrumSampleSet::Ptr DrumSampleSet::loadFrom(SamplePool& pool, const juce::File& source,
+                                           double playbackRate, DrumSample::Resampler resampler)
+{
+    Ptr set(new DrumSampleSet(source, playbackRate, resampler));
+
+    if (source.isDirectory())
+    {
+        auto layerFolders = source.findChildFiles(juce::File::findDirectories, false);
+        layerFolders.sort();
+
+        for (auto& folder : layerFolders)
+            set->addLayer(pool, findAudioFiles(folder), -1.0f);
+
+        //no layer folders, so everything in here is a round-robin of one layer
+        if (set->mLayers.empty())
+            set->addLayer(pool, findAudioFiles(source), -1.0f);
+    }
+    else if (source.hasFileExtension(manifestExtension))
+    {
+        auto manifest = juce::XmlDocument::parse(source);
+
+        if (manifest == nullptr)
+            return nullptr;
+
+        for (auto* layerXml : manifest->getChildWithTagNameIterator("Layer"))
+        {
+            juce::Array<juce::File> files;
+
+            for (auto* sampleXml : layerXml->getChildWithTagNameIterator("Sample"))
+                files.add(source.getSiblingFile(sampleXml->getStringAttribute("file")));
+
+            set->addLayer(pool, files, static_cast<float>(layerXml->getDoubleAttribute("maxVelocity", -1.0)));
+        }
+    }
+    else
+    {
+        set->addLayer(pool, { source }, -1.0f);
+    }
+
+    if (set->mLayers.empty())
+        return nullptr;
+
+    set->buildVelocityTable();
+    return set;
+}
+
+DrumSampleSet::Ptr DrumSampleSet::loadFromEmbedded(SamplePool& pool, const juce::XmlElement& layout, const EmbeddedAudio* audio,
+                                                   double playbackRate, DrumSample::Resampler resampler)
+{
+    Ptr set(new DrumSampleSet(juce::File::createFileWithoutCheckingPath(layout.getStringAttribute("source")), playbackRate, resampler));
+
+    for (auto* layerXml : layout.getChildWithTagNameIterator("Layer"))
+    {
+        Layer layer;
+        layer.maxVelocity = static_cast<float>(layerXml->getDoubleAttribute("maxVelocity", -1.0));
+
+        for (auto* sampleXml : layerXml->getChildWithTagNameIterator("Sample"))
+        {
+            auto hash = sampleXml->getStringAttribute("hash");
+            const juce::MemoryBlock* data = nullptr;
+
+            if (audio != nullptr)
+            {
+                auto it = audio->find(hash);
+
+                if (it != audio->end())
+                    data = &it->second;
+            }
+
+            auto sourceFile = juce::File::createFileWithoutCheckingPath(sampleXml->getStringAttribute("file"));
+
+            if (auto sample = pool.getEmbeddedSample(hash, data, sourceFile, playbackRate, resampler))
+                layer.variations.push_back(sample);
+        }
+
+        if (! layer.variations.empty())
+            set->mLayers.push_back(std::move(layer));
+    }
+
+    if (set->mLayers.empty())
+        return nullptr;
+
+    set->mEmbeddedLayout = std::make_shared<const juce::XmlElement>(layout);
+    set->buildVelocityTable();
+    return set;
+}
+
+std::unique_ptr<juce::XmlElement> DrumSampleSet::createEmbeddedXml(SamplePool& pool, EmbeddedAudio& audio) const
+{
+    auto layout = std::make_unique<juce::XmlElement>("Set");
+    layout->setAttribute("source", mSource.getFullPathName());
+
+    auto hasSamples = false;
+
+    for (auto& layer : mLayers)
+    {
+        auto* layerXml = layout->createNewChildElement("Layer");
+        layerXml->setAttribute("maxVelocity", layer.maxVelocity);
+
+        for (auto& sample : layer.variations)
+        {
+            juce::String hash;
+            juce::MemoryBlock data;
+
+            if (! pool.getLosslessData(*sample, hash, data))
+                continue;
+
+            auto* sampleXml = layerXml->createNewChildElement("Sample");
+            sampleXml->setAttribute("hash", hash);
+            sampleXml->setAttribute("file", sample->getFile().getFullPathName());
+
+            audio[hash] = std::move(data);
+            hasSamples = true;
+        }
+    }
+
+    if (! hasSamples)
+        return nullptr;
+
+    return layout;
+}
+
+juce::Array<juce::File> DrumSampleSet::findAudioFiles(const juce::File& folder)
+{
+    auto files = folder.findChildFiles(juce::File::findFiles, false, audioFileWildcard);
+    files.sort();
+    return files;
+}
+
+void DrumSampleSet::addLayer(SamplePool& pool, const juce::Array<juce::File>& files, float maxVelocity)
+{
+    Layer layer;
+    layer.maxVelocity = maxVelocity;
+
+    for (auto& file : files)
+        if (auto sample = pool.getSample(file, mPlaybackRate, mResampler))
+            layer.variations.push_back(sample);
+
+    //a layer that failed to decode entirely is left out rather than played as silence
+    if (! layer.variations.empty())
+        mLayers.push_back(std::move(layer));
+}
+
+void DrumSampleSet::buildVelocityTable() noexcept
+{
+    auto numLayers = getNumLayers();
+
+    //every layer tops out at its manifest velocity, never below the layer under it. layers without one share
+    //the range evenly between their neighbours that have one, or up to the top for the loudest of them.
+    std::vector<float> upperBounds(static_cast<size_t>(numLayers), 0.0f);
+    auto lowerBound = 0.0f;
+    auto runStart = 0;//the first layer since the last one with a manifest velocity
+
+    for (int i = 0; i <= numLayers; ++i)
+    {
+        auto isEnd = i == numLayers;
+        auto maxVelocity = isEnd ? -1.0f : mLayers[static_cast<size_t>(i)].maxVelocity;
+
+        if (! isEnd && maxVelocity < 0.0f)
+            continue;
+
+        //the layers in the run split the gap up to this bound, which the last of them reaches at the top
+        auto upperBound = isEnd ? 1.0f : juce::jmax(lowerBound, maxVelocity);
+        auto numShares = isEnd ? i - runStart : i - runStart + 1;
+
+        for (int j = runStart; j < i; ++j)
+            upperBounds[static_cast<size_t>(j)] = lowerBound + (upperBound - lowerBound) * static_cast<float>(j - runStart + 1) / static_cast<float>(numShares);
+
+        if (! isEnd)
+            upperBounds[static_cast<size_t>(i)] = upperBound;
+
+        lowerBound = upperBound;
+        runStart = i + 1;
+    }
+
+    upperBounds.back() = std::numeric_limits<float>::max();
+
+    auto layer = 0;
+
+    for (int i = 0; i < velocityResolution; ++i)
+    {
+        auto velocity = static_cast<float>(i) / static_cast<float>(velocityResolution - 1);
+
+        while (layer < numLayers - 1 && velocity > upperBounds[static_cast<size_t>(layer)])
+            ++layer;
+
+        mVelocityToLayer[static_cast<size_t>(i)] = layer;
+    }
+
+    mRoundRobinPositions.assign(static_cast<size_t>(numLayers), 0);
+}
+
+//==============================================================================
+const DrumSample* DrumSampleSet::selectSample(float velocity) noexcept
+{
+    auto index = juce::jlimit(0, velocityResolution - 1, static_cast<int>(velocity * static_cast<float>(velocityResolution - 1) + 0.5f));
+    auto layerIndex = static_cast<size_t>(mVelocityToLayer[static_cast<size_t>(index)]);
+
+    auto& variations = mLayers[layerIndex].variations;
+    auto& position = mRoundRobinPositions[layerIndex];
+
+    auto* sample = variations[static_cast<size_t>(position)].get();
+
+    if (++position >= static_cast<int>(variations.size()))
+        position = 0;
+
+    return sample;
+}
+
+int DrumSampleSet::getNumVariations(int layer) const noexcept
+{
+    return juce::isPositiveAndBelow(layer, getNumLayers()) ? static_cast<int>(mLayers[static_cast<size_t>(layer)].variations.size()) : 0;
+}
+
+int DrumSampleSet::getNumSamples() const noexcept
+{
+    auto total = 0;
+
+    for (auto& layer : mLayers)
+        total += static_cast<int>(layer.variations.size());
+
+    return total;
+}
+
+size_t DrumSampleSet::getMemoryUsage() const noexcept
+{
+    size_t total = 0;
+
+    for (auto& layer : mLayers)
+        for (auto& sample : layer.variations)
+            total += sample->getMemoryUsage();
+
+    return total;
+}
+
+double DrumSampleSet::getMaxOnsetSeconds() const noexcept
+{
+    auto maxOnset = 0.0;
+
+    for (auto& layer : mLayers)
+        for (auto& sample : layer.variations)
+            maxOnset = juce::jmax(maxOnset, static_cast<double>(sample->getOnsetSample()) / sample->getSampleRate());
+
+    return maxOnset;
+}
+
+juce::String DrumSampleSet::getDescription() const
+{
+    auto megabytes = static_cast<double>(getMemoryUsage()) / (1024.0 * 1024.0);
+
+    return mSource.getFileName()
+         + " (" + juce::String(getNumLayers()) + " layers, "
+         + juce::String(getNumSamples()) + " samples, "
+         + juce::String(megabytes, 1) + " MB, "
+         + "onsets up to " + juce::String(getMaxOnsetSeconds() * 1000.0, 1) + " ms in)";
+}
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    DrumSampleSet.h
+
+    A set of replacement samples arranged as velocity layers, each holding any
+    number of round-robin variations. Every variation is decoded up front, and
+    picking one on the audio thread is a table lookup plus a counter step.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SamplePool.h"
+
+//==============================================================================
+/**
+    A set can be loaded from:
+     - a single audio file (one layer, one variation)
+     - a folder: each subfolder is a layer, softest first in name order, and the
+       audio files in it are its round-robins. A folder without subfolders is a
+       single layer.
+     - a manifest (.anydrum), an xml file listing the layers explicitly:
+
+        <AnyDrumSampleSet>
+          <Layer maxVelocity="0.4">
+            <Sample file="snare_soft_1.wav"/>
+            <Sample file="snare_soft_2.wav"/>
+          </Layer>
+          <Layer>
+            <Sample file="snare_hard_1.wav"/>
+          </Layer>
+        </AnyDrumSampleSet>
+
+    A set can also be embedded in a session, as its layout with every sample
+    named by content hash, plus the lossless audio for each hash.
+*/
+class DrumSampleSet  : public juce::ReferenceCountedObject
+{
+public:
+    //==============================================================================
+    using Ptr = juce::ReferenceCountedObjectPtr<DrumSampleSet>;
+
+    using EmbeddedAudio = std::map<juce::String, juce::MemoryBlock>;//lossless audio by content hash
+
+    static constexpr int velocityResolution = 128;
+
+    static bool isLoadableFile(const juce::File& file);
+
+    //returns nullptr if nothing in the file, folder or manifest could be decoded. every sample is converted
+    //to playbackRate on the way in, unless it's 0, and comes from the pool, so sets can share them.
+    static Ptr loadFrom(SamplePool& pool, const juce::File& source,
+                        double playbackRate = 0.0, DrumSample::Resampler resampler = DrumSample::Resampler::windowedSinc);
+
+    //rebuilds a set from a layout made by createEmbeddedXml(), without touching the disk. audio may be null
+    //when every hash is already archived in the pool, as it is for a reload at a new rate.
+    static Ptr loadFromEmbedded(SamplePool& pool, const juce::XmlElement& layout, const EmbeddedAudio* audio,
+                                double playbackRate = 0.0, DrumSample::Resampler resampler = DrumSample::Resampler::windowedSinc);
+
+    //the set's layout for embedding, adding the lossless audio of every sample to audio. may encode files,
+    //so not for the audio thread. returns nullptr if none of the samples could be archived.
+    std::unique_ptr<juce::XmlElement> createEmbeddedXml(SamplePool& pool, EmbeddedAudio& audio) const;
+
+    //==============================================================================
+    //picks the layer for this velocity and steps its round-robin. safe to call from the audio thread.
+    const DrumSample* selectSample(float velocity) noexcept;
+
+    int getNumLayers() const noexcept               { return static_cast<int>(mLayers.size()); }
+    int getNumVariations(int layer) const noexcept;
+    int getNumSamples() const noexcept;
+
+    size_t getMemoryUsage() const noexcept;
+    juce::String getDescription() const;
+
+    //the most any sample skips by starting at its onset, in the time the hit would otherwise have come late by
+    double getMaxOnsetSeconds() const noexcept;
+
+    const juce::File& getSource() const noexcept    { return mSource; }
+    double getPlaybackRate() const noexcept         { return mPlaybackRate; }
+    DrumSample::Resampler getResampler() const noexcept { return mResampler; }
+
+    //the layout the set was restored from, or nullptr if it came from disk
+    std::shared_ptr<const juce::XmlElement> getEmbeddedLayout() const noexcept { return mEmbeddedLayout; }
+
+private:
+    //==============================================================================
+    struct Layer
+    {
+        std::vector<DrumSample::Ptr> variations;
+        float maxVelocity = -1.0f;//negative when the layer should take an even share of the range
+    };
+
+    DrumSampleSet(const juce::File& source, double playbackRate, DrumSample::Resampler resampler);
+
+    static juce::Array<juce::File> findAudioFiles(const juce::File& folder);
+    void addLayer(SamplePool& pool, const juce::Array<juce::File>& files, float maxVelocity);
+    void buildVelocityTable() noexcept;
+
+    juce::File mSource;
+    double mPlaybackRate = 0.0;
+    DrumSample::Resampler mResampler = DrumSample::Resampler::windowedSinc;
+    std::vector<Layer> mLayers;
+    std::shared_ptr<const juce::XmlElement> mEmbeddedLayout;
+
+    std::array<int, velocityResolution> mVelocityToLayer{};
+    std::vector<int> mRoundRobinPositions;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DrumSampleSet)
+};
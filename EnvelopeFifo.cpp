@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    EnvelopeFifo.cpp
+
+  ==============================================================================
+*/
+
+#include "EnvelopeFifo.h"
+
+//==============================================================================
+void EnvelopeFifo::prepare(double sampleRate) noexcept
+{
+    mWindowLength = juce::jmax(1, juce::roundToInt(sampleRate / pointsPerSecond));
+    mWindowCounter = 0;
+    mCurrentWindow = {};
+    mNumPendingTriggers = 0;
+}
+
+//==============================================================================
+void EnvelopeFifo::markTrigger(int sampleOffset) noexcept
+{
+    if (mNumPendingTriggers < maxTriggersPerBlock)
+        mPendingTriggers[static_cast<size_t>(mNumPendingTriggers++)] = sampleOffset;
+}
+
+void EnvelopeFifo::pushBlock(const juce::AudioBuffer<float>& buffer, int numChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin(numChannels, buffer.getNumChannels());
+
+    //windows run on across blocks, so a point always covers the same stretch of audio whatever the block size
+    for (int start = 0; start < numSamples;)
+    {
+        auto runLength = juce::jmin(numSamples - start, mWindowLength - mWindowCounter);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            mCurrentWindow.level = juce::jmax(mCurrentWindow.level, buffer.getMagnitude(channel, start, runLength));
+
+        for (int i = 0; i < mNumPendingTriggers; ++i)
+        {
+            auto offset = mPendingTriggers[static_cast<size_t>(i)];
+
+            if (offset >= start && offset < start + runLength)
+                mCurrentWindow.hasTrigger = true;
+        }
+
+        mWindowCounter += runLength;
+        start += runLength;
+
+        if (mWindowCounter >= mWindowLength)
+        {
+            push(mCurrentWindow);
+
+            mCurrentWindow = {};
+            mWindowCounter = 0;
+        }
+    }
+
+    mNumPendingTriggers = 0;
+}
+
+void EnvelopeFifo::push(const Point& point) noexcept
+{
+    int start1, size1, start2, size2;
+    mFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    //with nobody reading, new points are dropped until there's room again
+    if (size1 > 0)
+        mPoints[static_cast<size_t>(start1)] = point;
+
+    mFifo.finishedWrite(size1);
+}
+
+//==============================================================================
+int EnvelopeFifo::pull(Point* dest, int maxPoints) noexcept
+{
+    int start1, size1, start2, size2;
+    mFifo.prepareToRead(maxPoints, start1, size1, start2, size2);
+
+    std::copy_n(mPoints.begin() + start1, size1, dest);
+    std::copy_n(mPoints.begin() + start2, size2, dest + size1);
+
+    mFifo.finishedRead(size1 + size2);
+
+    return size1 + size2;
+}
+
+void EnvelopeFifo::discardPending() noexcept
+{
+    mFifo.finishedRead(mFifo.getNumReady());
+}
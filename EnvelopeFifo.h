@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    EnvelopeFifo.h
+
+    Carries the input envelope from the audio thread to the editor: one
+    point per short window of audio time, holding the window's peak and
+    whether a hit fired in it. Single producer, single consumer, lock-free.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class EnvelopeFifo
+{
+public:
+    //==============================================================================
+    struct Point
+    {
+        float level = 0.0f;
+        bool hasTrigger = false;
+    };
+
+    static constexpr int pointsPerSecond = 200;
+    static constexpr int capacity = 4096;//20 seconds of points, for when the editor is closed or stalls
+    static constexpr int maxTriggersPerBlock = 256;
+
+    //sets the window length for the new rate. call from prepareToPlay(), never while the audio thread is running.
+    void prepare(double sampleRate) noexcept;
+
+    //==============================================================================
+    //audio thread only. triggers are marked first, then the block that holds them is pushed.
+    void markTrigger(int sampleOffset) noexcept;
+    void pushBlock(const juce::AudioBuffer<float>& buffer, int numChannels, int numSamples) noexcept;
+
+    //==============================================================================
+    //message thread only. returns the number of points copied into dest, oldest first.
+    int pull(Point* dest, int maxPoints) noexcept;
+
+    //throws away everything waiting, so a newly opened editor starts from now
+    void discardPending() noexcept;
+
+private:
+    //==============================================================================
+    void push(const Point& point) noexcept;
+
+    juce::AbstractFifo mFifo{ capacity };
+    std::array<Point, capacity> mPoints;
+
+    //audio thread state
+    int mWindowLength = 240;
+    int mWindowCounter = 0;
+    Point mCurrentWindow;
+
+    std::array<int, maxTriggersPerBlock> mPendingTriggers{};
+    int mNumPendingTriggers = 0;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EnvelopeFifo)
+};
@@ -0,0 +1,292 @@
+/*
+  ==============================================================================
+
+    LatencyHarness.cpp
+
+  ==============================================================================
+*/
+
+#include "LatencyHarness.h"
+#include "PluginProcessor.h"
+#include <iostream>
+
+namespace
+{
+    const char* const detectors[] = { "Peak", "Spectral Flux" };
+    const int windows[] = { 64, 256, 1024 };//only changes the peak detector
+    const int offsets[] = { 0, 128, 512, 2048 };
+    const int masks[] = { 1000, 4000, 14000 };
+    const int blockSizes[] = { 32, 128, 512, 2048 };
+    const int lookaheadBlockSizes[] = { 128, 512 };
+}
+
+//==============================================================================
+LatencyHarness::LatencyHarness(const Settings& settings)
+    : mSettings(settings)
+{
+}
+
+bool LatencyHarness::run(const juce::File& outputFile)
+{
+    juce::AudioBuffer<float> signal(1, static_cast<int>(mSettings.sampleRate * mSettings.secondsPerRun));
+    auto onsets = createTestSignal(signal, mSettings.sampleRate);
+
+    juce::Array<juce::var> results;
+
+    for (auto* detector : detectors)
+    {
+        auto isPeak = juce::String(detector) == "Peak";
+
+        for (auto window : windows)
+        {
+            //spectral flux ignores the window, so it's only run once, at the default
+            if (! isPeak && window != 256)
+                continue;
+
+            for (auto offset : offsets)
+            {
+                for (auto mask : masks)
+                {
+                    for (auto blockSize : blockSizes)
+                    {
+                        auto result = runOne(signal, onsets, { detector, window, offset, mask, blockSize });
+
+                        if (result.isVoid())
+                            return false;
+
+                        std::cout << detector << ", window " << window << ", offset " << offset << ", mask " << mask << ", block " << blockSize << ": delay mean "
+                                  << static_cast<double>(result["meanDelayMs"]) << " ms, p99 " << static_cast<double>(result["p99DelayMs"])
+                                  << " ms, max " << static_cast<double>(result["maxDelayMs"]) << " ms, missed "
+                                  << static_cast<int>(result["missed"]) << ", doubles " << static_cast<int>(result["doubles"]) << std::endl;
+
+                        results.add(result);
+                    }
+                }
+            }
+        }
+    }
+
+    //with lookahead on, the host moves everything back by the reported latency, so a hit on a clean step
+    //should come out on the step's first sample, whatever the offset
+    juce::AudioBuffer<float> stepSignal(1, signal.getNumSamples());
+    auto stepOnsets = createStepSignal(stepSignal, mSettings.sampleRate);
+
+    juce::Array<juce::var> lookaheadResults;
+    auto isAligned = true;
+
+    for (auto offset : offsets)
+    {
+        for (auto blockSize : lookaheadBlockSizes)
+        {
+            auto result = runOne(stepSignal, stepOnsets, { "Peak", 256, offset, masks[0], blockSize, true });
+
+            if (result.isVoid())
+                return false;
+
+            auto mean = static_cast<double>(result["meanDelaySamples"]);
+            auto isExact = mean == 0.0 && static_cast<int>(result["maxDelaySamples"]) == 0 && static_cast<int>(result["missed"]) == 0;
+
+            std::cout << "lookahead, offset " << offset << ", block " << blockSize << ": delay mean " << mean << " samples, missed "
+                      << static_cast<int>(result["missed"]) << (isExact ? "" : " - NOT ALIGNED") << std::endl;
+
+            isAligned = isAligned && isExact;
+            lookaheadResults.add(result);
+        }
+    }
+
+    juce::DynamicObject::Ptr root(new juce::DynamicObject());
+    root->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("sampleRate", mSettings.sampleRate);
+    root->setProperty("seconds", mSettings.secondsPerRun);
+    root->setProperty("onsets", onsets.size());
+    root->setProperty("results", results);
+    root->setProperty("lookaheadAligned", isAligned);
+    root->setProperty("lookaheadResults", lookaheadResults);
+
+    return outputFile.replaceWithText(juce::JSON::toString(juce::var(root.get()))) && isAligned;
+}
+
+juce::var LatencyHarness::runOne(const juce::AudioBuffer<float>& signal, const juce::Array<int>& onsets, const ParameterSet& parameterSet)
+{
+    auto sampleRate = mSettings.sampleRate;
+    auto blockSize = parameterSet.blockSize;
+    auto numSamples = signal.getNumSamples();
+
+    AnyDrum001AudioProcessor processor;
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(juce::AudioChannelSet::mono());
+    layout.outputBuses.add(juce::AudioChannelSet::mono());
+
+    if (! processor.setBusesLayout(layout))
+        return {};
+
+    //midi only: the note-ons say exactly where each hit fired, with no sample needed.
+    //without lookahead, what's measured is the raw detection delay.
+    processor.setParameterFromText("toggle", "1");
+    processor.setParameterFromText("threshold", "0.2");
+    processor.setParameterFromText("outputmode", "MIDI Only");
+    processor.setParameterFromText("lookahead", parameterSet.lookahead ? "1" : "0");
+    processor.setParameterFromText("detector", parameterSet.detector);
+    processor.setParameterFromText("window", juce::String(parameterSet.window));
+    processor.setParameterFromText("offset", juce::String(parameterSet.offset));
+    processor.setParameterFromText("mask", juce::String(parameterSet.mask));
+
+    for (auto& parameterID : mSettings.parameterValues.getAllKeys())
+        if (! processor.setParameterFromText(parameterID, mSettings.parameterValues[parameterID]))
+            return {};
+
+    processor.setNonRealtime(true);
+    processor.setPlayConfigDetails(1, 1, sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    juce::AudioBuffer<float> buffer(1, blockSize);
+    juce::MidiBuffer midiMessages;
+    juce::Array<int> hits;
+    auto compensation = parameterSet.lookahead ? processor.getLatencySamples() : 0;
+
+    for (int start = 0; start < numSamples; start += blockSize)
+    {
+        auto numThisBlock = juce::jmin(blockSize, numSamples - start);
+
+        buffer.setSize(1, numThisBlock, false, false, true);
+        buffer.copyFrom(0, 0, signal, 0, start, numThisBlock);
+        midiMessages.clear();
+
+        processor.processBlock(buffer, midiMessages);
+
+        for (const auto metadata : midiMessages)
+            if (metadata.getMessage().isNoteOn())
+                hits.add(start + metadata.samplePosition - compensation);
+    }
+
+    processor.releaseResources();
+
+    auto measurement = measure(onsets, hits);
+    auto& delays = measurement.delays;
+    std::sort(delays.begin(), delays.end());
+
+    auto toMs = [sampleRate](double samples) { return samples * 1000.0 / sampleRate; };
+
+    auto mean = 0.0;
+
+    for (auto delay : delays)
+        mean += delay;
+
+    mean /= juce::jmax(1, delays.size());
+
+    auto p99 = delays.isEmpty() ? 0 : delays[juce::jmax(0, static_cast<int>(std::ceil(0.99 * delays.size())) - 1)];
+    auto max = delays.isEmpty() ? 0 : delays.getLast();
+
+    juce::DynamicObject::Ptr result(new juce::DynamicObject());
+    result->setProperty("detector", parameterSet.detector);
+    result->setProperty("window", parameterSet.window);
+    result->setProperty("offset", parameterSet.offset);
+    result->setProperty("mask", parameterSet.mask);
+    result->setProperty("blockSize", blockSize);
+    result->setProperty("lookahead", parameterSet.lookahead);
+    result->setProperty("expectedLatency", processor.getDetectionLatencySamples());
+    result->setProperty("meanDelaySamples", mean);
+    result->setProperty("p99DelaySamples", p99);
+    result->setProperty("maxDelaySamples", max);
+    result->setProperty("meanDelayMs", toMs(mean));
+    result->setProperty("p99DelayMs", toMs(p99));
+    result->setProperty("maxDelayMs", toMs(max));
+    result->setProperty("onsets", measurement.numOnsets);
+    result->setProperty("missed", measurement.numMissed);
+    result->setProperty("doubles", measurement.numDoubles);
+    result->setProperty("spurious", measurement.numSpurious);
+
+    return juce::var(result.get());
+}
+
+//==============================================================================
+juce::Array<int> LatencyHarness::createTestSignal(juce::AudioBuffer<float>& signal, double sampleRate)
+{
+    juce::Random random(4321);//fixed seed, so every run sees the same track
+
+    auto numSamples = signal.getNumSamples();
+    auto* samples = signal.getWritePointer(0);
+    auto decay = std::exp(-1.0 / (0.04 * sampleRate));//40ms time constant
+
+    juce::Array<int> onsets;
+    auto nextOnset = static_cast<int>(sampleRate * 0.25);
+    auto envelope = 0.0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (i == nextOnset)
+        {
+            onsets.add(i);
+            envelope = 0.3 + 0.7 * random.nextDouble();
+
+            //anywhere from 16ths at 100 bpm to half a second apart
+            nextOnset += static_cast<int>(sampleRate * (0.15 + 0.35 * random.nextDouble()));
+        }
+
+        auto noise = random.nextFloat() * 2.0f - 1.0f;
+        samples[i] = static_cast<float>(noise * (envelope + 0.001));
+        envelope *= decay;
+    }
+
+    return onsets;
+}
+
+juce::Array<int> LatencyHarness::createStepSignal(juce::AudioBuffer<float>& signal, double sampleRate)
+{
+    auto numSamples = signal.getNumSamples();
+    auto* samples = signal.getWritePointer(0);
+
+    //longer than any offset the sweep uses, and a second apart so the mask has always let go
+    auto burstLength = static_cast<int>(sampleRate * 0.1);
+    auto spacing = static_cast<int>(sampleRate);
+
+    juce::Array<int> onsets;
+    signal.clear();
+
+    for (int onset = static_cast<int>(sampleRate * 0.25); onset + burstLength < numSamples; onset += spacing)
+    {
+        onsets.add(onset);
+
+        for (int i = 0; i < burstLength; ++i)
+            samples[onset + i] = (i % 2 == 0) ? 0.8f : -0.8f;
+    }
+
+    return onsets;
+}
+
+LatencyHarness::Measurement LatencyHarness::measure(const juce::Array<int>& onsets, const juce::Array<int>& hits)
+{
+    Measurement measurement;
+    measurement.numOnsets = onsets.size();
+
+    juce::Array<int> hitsPerOnset;
+    hitsPerOnset.insertMultiple(0, 0, onsets.size());
+
+    int onsetIndex = -1;
+
+    for (auto hit : hits)
+    {
+        while (onsetIndex + 1 < onsets.size() && onsets[onsetIndex + 1] <= hit)
+            ++onsetIndex;
+
+        if (onsetIndex < 0)
+        {
+            ++measurement.numSpurious;
+            continue;
+        }
+
+        if (hitsPerOnset[onsetIndex] == 0)
+            measurement.delays.add(hit - onsets[onsetIndex]);
+        else
+            ++measurement.numDoubles;
+
+        hitsPerOnset.set(onsetIndex, hitsPerOnset[onsetIndex] + 1);
+    }
+
+    for (auto count : hitsPerOnset)
+        if (count == 0)
+            ++measurement.numMissed;
+
+    return measurement;
+}
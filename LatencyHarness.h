@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    LatencyHarness.h
+
+    Feeds deterministic synthetic drum tracks with known onset times through
+    AnyDrum001AudioProcessor and measures, from the midi it sends back, how
+    late each hit fires and how many are missed or doubled, across a sweep
+    of detector settings and block sizes. It then checks that in lookahead
+    mode, once the reported latency is compensated, hits land exactly on
+    their onsets.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class LatencyHarness
+{
+public:
+    //==============================================================================
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        double secondsPerRun = 30.0;
+        juce::StringPairArray parameterValues;//applied on top of the harness's own settings
+    };
+
+    explicit LatencyHarness(const Settings& settings);
+
+    //runs every parameter set and writes the results to outputFile. returns false if nothing could run,
+    //or if a lookahead hit didn't land on its onset.
+    bool run(const juce::File& outputFile);
+
+    //==============================================================================
+    //a mono drum track with hits at seeded random spacings and levels. returns the onset of every hit.
+    static juce::Array<int> createTestSignal(juce::AudioBuffer<float>& signal, double sampleRate);
+
+    //a mono track of bursts held at one level, each crossing any threshold below it on its very first sample
+    static juce::Array<int> createStepSignal(juce::AudioBuffer<float>& signal, double sampleRate);
+
+    struct Measurement
+    {
+        juce::Array<int> delays;//from each detected onset to its first hit, in samples
+        int numOnsets = 0;
+        int numMissed = 0;
+        int numDoubles = 0;//extra hits on an onset that had already fired
+        int numSpurious = 0;//hits before the first onset
+    };
+
+    //pairs every hit, in time order, with the latest onset at or before it
+    static Measurement measure(const juce::Array<int>& onsets, const juce::Array<int>& hits);
+
+private:
+    //==============================================================================
+    struct ParameterSet
+    {
+        juce::String detector;
+        int window;
+        int offset;
+        int mask;
+        int blockSize;
+        bool lookahead = false;//hits are then moved back by the reported latency, as the host would
+    };
+
+    juce::var runOne(const juce::AudioBuffer<float>& signal, const juce::Array<int>& onsets, const ParameterSet& parameterSet);
+
+    Settings mSettings;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LatencyHarness)
+};
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    MidiTriggerOutput.cpp
+
+  ==============================================================================
+*/
+
+#include "MidiTriggerOutput.h"
+
+//==============================================================================
+void MidiTriggerOutput::prepare(double sampleRate) noexcept
+{
+    //drum samplers mostly ignore note length, so a short fixed gate does
+    mNoteLength = juce::jmax(1, static_cast<int>(sampleRate * 0.05));
+    reset();
+}
+
+void MidiTriggerOutput::reset() noexcept
+{
+    mNoteOffPositions.fill(-1);
+}
+
+bool MidiTriggerOutput::addHit(juce::MidiBuffer& midiMessages, int noteNumber, float amplitude, int sampleOffset) noexcept
+{
+    if (! juce::isPositiveAndBelow(noteNumber, 128))
+        return false;
+
+    auto note = noteNumber;
+    auto& noteOffPosition = mNoteOffPositions[static_cast<size_t>(note)];
+
+    if (noteOffPosition >= 0)
+        midiMessages.addEvent(juce::MidiMessage::noteOff(midiChannel, note), juce::jmin(noteOffPosition, sampleOffset));
+
+    midiMessages.addEvent(juce::MidiMessage::noteOn(midiChannel, note, amplitudeToVelocity(amplitude)), sampleOffset);
+    noteOffPosition = sampleOffset + mNoteLength;
+    return true;
+}
+
+void MidiTriggerOutput::finishBlock(juce::MidiBuffer& midiMessages, int numSamples) noexcept
+{
+    for (int note = 0; note < 128; ++note)
+    {
+        auto& noteOffPosition = mNoteOffPositions[static_cast<size_t>(note)];
+
+        if (noteOffPosition < 0)
+            continue;
+
+        if (noteOffPosition < numSamples)
+        {
+            midiMessages.addEvent(juce::MidiMessage::noteOff(midiChannel, note), noteOffPosition);
+            noteOffPosition = -1;
+        }
+        else
+        {
+            noteOffPosition -= numSamples;
+        }
+    }
+}
+
+juce::uint8 MidiTriggerOutput::amplitudeToVelocity(float amplitude) noexcept
+{
+    return static_cast<juce::uint8>(juce::jlimit(1, 127, juce::roundToInt(amplitude * 127.0f)));
+}
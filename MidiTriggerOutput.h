@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    MidiTriggerOutput.h
+
+    Turns detected hits into sample-accurate midi notes, so the detector can
+    drive an external drum sampler. Note-offs that land in a later block are
+    remembered here and written out when their block comes round.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class MidiTriggerOutput
+{
+public:
+    //==============================================================================
+    static constexpr int midiChannel = 1;
+
+    MidiTriggerOutput() noexcept                    { reset(); }
+
+    void prepare(double sampleRate) noexcept;
+    void reset() noexcept;
+
+    //writes a note-on at sampleOffset, with its velocity taken from the hit's amplitude.
+    //a note that's still held is released first, so retriggers never overlap. a note number outside
+    //0-127 isn't clamped onto another kit piece's note: nothing is sent and false is returned.
+    bool addHit(juce::MidiBuffer& midiMessages, int noteNumber, float amplitude, int sampleOffset) noexcept;
+
+    //writes the note-offs that fall inside this block. call once per block, after addHit().
+    void finishBlock(juce::MidiBuffer& midiMessages, int numSamples) noexcept;
+
+    static juce::uint8 amplitudeToVelocity(float amplitude) noexcept;
+
+private:
+    //==============================================================================
+    //samples from the start of the current block until each note's note-off, or -1 if it isn't held
+    std::array<int, 128> mNoteOffPositions;
+    int mNoteLength = 2205;
+};
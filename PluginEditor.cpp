@@ -11,11 +11,18 @@
 
 //==============================================================================
 AnyDrum001AudioProcessorEditor::AnyDrum001AudioProcessorEditor (AnyDrum001AudioProcessor& p, juce::AudioProcessorValueTreeState& vts)
-    : AudioProcessorEditor (&p), audioProcessor (p), valueTreeState(vts)
+    : AudioProcessorEditor (&p), audioProcessor (p), valueTreeState(vts), mDiagnosticsPanel(p.getTelemetry())
 {
     openGlContext.attachTo(*this);
 
-    Timer::startTimerHz(120);
+    //whatever piled up while no editor was open is stale
+    audioProcessor.getEnvelopeFifo().discardPending();
+
+    renderBackground();
+    mGraphImage = juce::Image(juce::Image::ARGB, graphWidth, graphHeight, true);
+
+    //the graph follows the display's refresh; the timer only keeps the file name up to date
+    Timer::startTimerHz(4);
 
     setSize (578, 384);
     setResizable(false, false);
@@ -49,6 +56,22 @@ AnyDrum001AudioProcessorEditor::AnyDrum001AudioProcessorEditor (AnyDrum001AudioP
     mFileNameLabel.setLookAndFeel(&nameTextLnF);
     mFileNameLabel.setJustificationType(juce::Justification::centredLeft);
     mFileNameLabel.setFont(getCustomFont().withHeight(16.0f).withStyle(juce::Font::plain));
+    mFileNameLabel.addMouseListener(this, false);
+    updateFileName();
+
+    //setting up kit slot selector
+    mSlotBox.setLookAndFeel(&buttonLnF);
+    addAndMakeVisible(&mSlotBox);
+
+    for (int slot = 0; slot < DrumKit::numSlots; ++slot)
+        mSlotBox.addItem(juce::String(slot + 1), slot + 1);
+
+    mSlotBox.setSelectedId(audioProcessor.getSelectedSlot() + 1, juce::dontSendNotification);
+    mSlotBox.setTooltip("Kit slot. In Per Channel mode each input channel plays the sample in its own slot, or slot 1 if that's empty.");
+    mSlotBox.onChange = [this]
+    {
+        audioProcessor.setSelectedSlot(mSlotBox.getSelectedId() - 1);
+    };
 
     //setting up trigger toggle
     mTriggerToggleSlider.setLookAndFeel(&toggleSliderLnF);
@@ -68,10 +91,10 @@ AnyDrum001AudioProcessorEditor::AnyDrum001AudioProcessorEditor (AnyDrum001AudioP
     mGainLabel.setLookAndFeel(&labelLnF);
     mGainLabel.setJustificationType(juce::Justification::centred);
     mGainLabel.setFont(getCustomFont().withHeight(16.0f).withStyle(juce::Font::bold));
-    mGainLabel.setText(juce::String(mGainSlider.getValue(), 2), juce::dontSendNotification);
     mGainLabel.setVisible(false);
 
     mGainAttachent.reset(new SliderAttachment(valueTreeState, "gain", mGainSlider));
+    showValueLabelWhileDragging(mGainSlider, mGainLabel, 2);
 
     //setting up thresh knob
     mThresholdSlider.setLookAndFeel(&customLnF);
@@ -83,10 +106,16 @@ AnyDrum001AudioProcessorEditor::AnyDrum001AudioProcessorEditor (AnyDrum001AudioP
     mThresLabel.setLookAndFeel(&labelLnF);
     mThresLabel.setJustificationType(juce::Justification::centred);
     mThresLabel.setFont(getCustomFont().withHeight(16.0f).withStyle(juce::Font::bold));
-    mThresLabel.setText(juce::String(mThresholdSlider.getValue(), 2), juce::dontSendNotification);
     mThresLabel.setVisible(false);
 
     mThresholdAttachment.reset(new SliderAttachment(valueTreeState, "threshold", mThresholdSlider));
+    showValueLabelWhileDragging(mThresholdSlider, mThresLabel, 2);
+
+    mThresholdSlider.onValueChange = [this]
+    {
+        updateValueLabel(mThresholdSlider, mThresLabel, 2);
+        repaintGraph();//the threshold line moves with it
+    };
 
     //setting up offset knob
     mOffsetSlider.setLookAndFeel(&customLnF);
@@ -98,10 +127,10 @@ AnyDrum001AudioProcessorEditor::AnyDrum001AudioProcessorEditor (AnyDrum001AudioP
     mOffsetLabel.setLookAndFeel(&labelLnF);
     mOffsetLabel.setJustificationType(juce::Justification::centred);
     mOffsetLabel.setFont(getCustomFont().withHeight(16.0f).withStyle(juce::Font::bold));
-    mOffsetLabel.setText(juce::String(mOffsetSlider.getValue(), 0), juce::dontSendNotification);
     mOffsetLabel.setVisible(false);
 
     mOffsetAttachent.reset(new SliderAttachment(valueTreeState, "offset", mOffsetSlider));
+    showValueLabelWhileDragging(mOffsetSlider, mOffsetLabel, 0);
 
     //setting up mask knob
     mMaskSlider.setLookAndFeel(&customLnF);
@@ -113,10 +142,10 @@ AnyDrum001AudioProcessorEditor::AnyDrum001AudioProcessorEditor (AnyDrum001AudioP
     mMaskLabel.setLookAndFeel(&labelLnF);
     mMaskLabel.setJustificationType(juce::Justification::centred);
     mMaskLabel.setFont(getCustomFont().withHeight(16.0f).withStyle(juce::Font::bold));
-    mMaskLabel.setText(juce::String(mMaskSlider.getValue()), juce::dontSendNotification);
     mMaskLabel.setVisible(false);
 
     mMaskAttachent.reset(new SliderAttachment(valueTreeState, "mask", mMaskSlider));
+    showValueLabelWhileDragging(mMaskSlider, mMaskLabel, 0);
 
     //setting up output knob
     mOutputSlider.setLookAndFeel(&customLnF);
@@ -128,10 +157,22 @@ AnyDrum001AudioProcessorEditor::AnyDrum001AudioProcessorEditor (AnyDrum001AudioP
     mOutputLabel.setLookAndFeel(&labelLnF);
     mOutputLabel.setJustificationType(juce::Justification::centred);
     mOutputLabel.setFont(getCustomFont().withHeight(16.0f).withStyle(juce::Font::bold));
-    mOutputLabel.setText(juce::String(mOutputSlider.getValue()), juce::dontSendNotification);
     mOutputLabel.setVisible(false);
 
     mOutputAttachent.reset(new SliderAttachment(valueTreeState, "output", mOutputSlider));
+    showValueLabelWhileDragging(mOutputSlider, mOutputLabel, 2);
+
+    //setting up diagnostics, shown over the graph
+    mDiagnosticsButton.setLookAndFeel(&buttonLnF);
+    mDiagnosticsButton.setClickingTogglesState(true);
+    mDiagnosticsButton.setTooltip("Diagnostics");
+    addAndMakeVisible(&mDiagnosticsButton);
+    mDiagnosticsButton.onClick = [this]
+    {
+        mDiagnosticsPanel.setVisible(mDiagnosticsButton.getToggleState());
+    };
+
+    addChildComponent(&mDiagnosticsPanel);
 
     //setting up file drag rectangle
     addAndMakeVisible(&mFileDragRect);
@@ -145,6 +186,8 @@ AnyDrum001AudioProcessorEditor::~AnyDrum001AudioProcessorEditor()
 
     mOpenButton.setLookAndFeel(nullptr);
     mFileNameLabel.setLookAndFeel(nullptr);
+    mSlotBox.setLookAndFeel(nullptr);
+    mDiagnosticsButton.setLookAndFeel(nullptr);
 
     mTriggerToggleSlider.setLookAndFeel(nullptr);
 
@@ -160,77 +203,46 @@ AnyDrum001AudioProcessorEditor::~AnyDrum001AudioProcessorEditor()
 //==============================================================================
 void AnyDrum001AudioProcessorEditor::paint (juce::Graphics& g)
 {
-    //background image should be bg006DEMO, for the demo version
-    juce::Image background = juce::ImageCache::getFromMemory(BinaryData::bg006_png, BinaryData::bg006_pngSize);
-    g.drawImageAt(background, 0, 0);
+    g.drawImageAt(mBackground, 0, 0);
 
     paintHistogram(g);
 
-    //painting the threshold line
-    int threshHeight = static_cast<int>(valueTreeState.getParameter("threshold")->getValue() * 205);
+    //painting the threshold line, kept inside the graph so it never covers the white line at the top
+    int threshHeight = static_cast<int>(valueTreeState.getParameter("threshold")->getValue() * graphHeight);
 
+    g.reduceClipRegion(margin, margin, graphWidth, graphHeight);
     g.setColour(juce::Colour(154u, 87u, 205u));
-    g.fillRect(margin + 0, margin + 205 - threshHeight - 2, 554, 2);
+    g.fillRect(margin + 0, margin + graphHeight - threshHeight - 2, graphWidth, 2);
+}
+
+void AnyDrum001AudioProcessorEditor::renderBackground()
+{
+    //background image should be bg006DEMO, for the demo version
+    mBackground = juce::Image(juce::Image::RGB, 578, 384, true);
+    juce::Graphics g(mBackground);
+
+    g.drawImageAt(juce::ImageCache::getFromMemory(BinaryData::bg006_png, BinaryData::bg006_pngSize), 0, 0);
 
     //white line at top of visualizer
     g.setColour(juce::Colour(242u, 242u, 242u));
-    g.fillRect(margin, margin - 2, 554, 2);
+    g.fillRect(margin, margin - 2, graphWidth, 2);
 
     //dark grey bar at top of screen
     g.setColour(juce::Colour(37u, 36u, 34u));
     g.fillRect(0, 0, 578, 10);
-
-    //======================================================
-
-    if (audioProcessor.currentlyLoadedFile.existsAsFile())
-        mFileNameLabel.setText(juce::String(audioProcessor.currentlyLoadedFile.getFileName()), juce::dontSendNotification);
-    else
-        mFileNameLabel.setText(juce::String("Choose a file..."), juce::dontSendNotification);
-
-    if (mGainSlider.isMouseButtonDown(false) == true)
-    {
-        mGainLabel.setVisible(true);
-        mGainLabel.setText(juce::String(mGainSlider.getValue(), 2), juce::dontSendNotification);
-    }
-    else
-        mGainLabel.setVisible(false);
-    if (mThresholdSlider.isMouseButtonDown(false) == true)
-    {
-        mThresLabel.setVisible(true);
-        mThresLabel.setText(juce::String(mThresholdSlider.getValue(), 2), juce::dontSendNotification);
-    }
-    else
-        mThresLabel.setVisible(false);
-    if (mOffsetSlider.isMouseButtonDown(false) == true)
-    {
-        mOffsetLabel.setVisible(true);
-        mOffsetLabel.setText(juce::String(mOffsetSlider.getValue(), 0), juce::dontSendNotification);
-    }
-    else
-        mOffsetLabel.setVisible(false);
-    if (mMaskSlider.isMouseButtonDown(false) == true)
-    {
-        mMaskLabel.setVisible(true);
-        mMaskLabel.setText(juce::String(mMaskSlider.getValue(), 0), juce::dontSendNotification);
-    }
-    else
-        mMaskLabel.setVisible(false);
-    if (mOutputSlider.isMouseButtonDown(false) == true)
-    {
-        mOutputLabel.setVisible(true);
-        mOutputLabel.setText(juce::String(mOutputSlider.getValue(), 2), juce::dontSendNotification);
-    }
-    else
-        mOutputLabel.setVisible(false);
 }
 
 void AnyDrum001AudioProcessorEditor::resized()
 {
     mOpenButton.setBounds(10, 226, 38, 31);
-    mFileNameLabel.setBounds(54, 228, 116, 27);
+    mFileNameLabel.setBounds(54, 228, 80, 27);
+    mSlotBox.setBounds(138, 229, 42, 25);
 
     mTriggerToggleSlider.setBounds(187, 232, 44, 20);
 
+    mDiagnosticsButton.setBounds(546, 230, 22, 22);
+    mDiagnosticsPanel.setBounds(margin, margin, 554, 205);
+
     mGainSlider.setBounds(35, 280, 60, 60); mGainLabel.setBounds(29, 352, 72, 22);
     mThresholdSlider.setBounds(147, 280, 60, 60); mThresLabel.setBounds(141, 352, 72, 22);
     mOffsetSlider.setBounds(259, 280, 60, 60); mOffsetLabel.setBounds(253, 352, 72, 22);
@@ -242,45 +254,139 @@ void AnyDrum001AudioProcessorEditor::resized()
 
 void AnyDrum001AudioProcessorEditor::paintHistogram(juce::Graphics& g)
 {
-    int ampHeight = static_cast<int>(audioProcessor.mAmplitude * 205);//205 is the height of the graph area
+    //oldest columns first, then the ones that have wrapped round to the start of the image
+    auto numOldest = graphWidth - mHistoryPosition;
+
+    g.drawImage(mGraphImage, margin, margin, numOldest, graphHeight, mHistoryPosition, 0, numOldest, graphHeight);
+
+    if (mHistoryPosition > 0)
+        g.drawImage(mGraphImage, margin + numOldest, margin, mHistoryPosition, graphHeight, 0, 0, mHistoryPosition, graphHeight);
+}
+
+bool AnyDrum001AudioProcessorEditor::pullEnvelope()
+{
+    std::array<EnvelopeFifo::Point, 256> points;
+    auto& fifo = audioProcessor.getEnvelopeFifo();
+    auto hasChanged = false;
+    int numPulled;
 
-    for (int i = 0; i < 553; i++)//553 = width of graph area -1
+    while ((numPulled = fifo.pull(points.data(), static_cast<int>(points.size()))) > 0)
     {
-        rectArray[i] = rectArray[i + 1];
+        juce::Graphics g(mGraphImage);
+
+        for (int i = 0; i < numPulled; ++i)
+        {
+            const auto& point = points[static_cast<size_t>(i)];
+            auto ampHeight = juce::jmin(graphHeight, static_cast<int>(point.level * graphHeight));
+
+            //once every column is empty, more empty ones change nothing on screen
+            auto isQuiet = ampHeight == 0 && ! point.hasTrigger;
+            mNumQuietColumns = isQuiet ? mNumQuietColumns + 1 : 0;
+
+            if (mNumQuietColumns > graphWidth)
+            {
+                mHistoryPosition = (mHistoryPosition + 1) % graphWidth;
+                continue;
+            }
+
+            hasChanged = true;
+            mGraphImage.clear({ mHistoryPosition, 0, 1, graphHeight });
+
+            g.setColour(juce::Colours::lightblue);
+            g.fillRect(mHistoryPosition, graphHeight - ampHeight, 1, ampHeight);
+
+            //a mark at the top of the graph wherever the detector fired
+            if (point.hasTrigger)
+            {
+                g.setColour(juce::Colour(154u, 87u, 205u));
+                g.fillRect(mHistoryPosition, 0, 1, 8);
+            }
+
+            mHistoryPosition = (mHistoryPosition + 1) % graphWidth;
+        }
     }
-    rectArray[553] = ampHeight;
 
-    for (int i = 0; i < 554; i++)
+    return hasChanged;
+}
+
+void AnyDrum001AudioProcessorEditor::repaintGraph()
+{
+    //nothing outside the graph changes from frame to frame
+    repaint(margin, margin, graphWidth, graphHeight);
+}
+
+void AnyDrum001AudioProcessorEditor::updateFileName()
+{
+    auto description = audioProcessor.getLoadedSampleDescription();
+
+    //a set restored from the session plays even where its file doesn't exist
+    auto name = audioProcessor.currentlyLoadedFile.exists() || description.isNotEmpty() ? audioProcessor.currentlyLoadedFile.getFileName()
+                                                                                       : juce::String("Choose a file...");
+
+    //labels repaint themselves, but only when the text actually changes
+    mFileNameLabel.setText(name, juce::dontSendNotification);
+    mFileNameLabel.setTooltip(description);
+}
+
+void AnyDrum001AudioProcessorEditor::showSampleMenu()
+{
+    juce::PopupMenu menu;
+    menu.addItem("Embed samples in session", true, audioProcessor.getEmbedSamples(), [this]
     {
-        g.setColour(juce::Colours::lightblue);
-        g.fillRect(margin + i, margin + 205 - rectArray[i], 1, rectArray[i]);
-    }
+        audioProcessor.setEmbedSamples(! audioProcessor.getEmbedSamples());
+    });
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&mFileNameLabel));
 }
 
-void AnyDrum001AudioProcessorEditor::timerCallback()
+void AnyDrum001AudioProcessorEditor::showValueLabelWhileDragging(juce::Slider& slider, juce::Label& label, int numDecimals)
+{
+    slider.onDragStart = [this, &slider, &label, numDecimals]
+    {
+        updateValueLabel(slider, label, numDecimals);
+        label.setVisible(true);
+    };
+
+    slider.onDragEnd = [&label]
+    {
+        label.setVisible(false);
+    };
+
+    slider.onValueChange = [this, &slider, &label, numDecimals]
+    {
+        updateValueLabel(slider, label, numDecimals);
+    };
+}
+
+void AnyDrum001AudioProcessorEditor::updateValueLabel(juce::Slider& slider, juce::Label& label, int numDecimals)
 {
-    if (this->isMouseOverOrDragging(true) == true)
-        Timer::startTimerHz(120);
-    else
-        Timer::stopTimer();
+    label.setText(juce::String(slider.getValue(), numDecimals), juce::dontSendNotification);
+}
 
-    repaint();
+void AnyDrum001AudioProcessorEditor::timerCallback()
+{
+    updateFileName();
 }
 
-void AnyDrum001AudioProcessorEditor::mouseEnter(const juce::MouseEvent& event)
+void AnyDrum001AudioProcessorEditor::mouseDown(const juce::MouseEvent& event)
 {
-    timerCallback();
+    //right-clicking the file name brings up the sample options
+    if (event.eventComponent == &mFileNameLabel && event.mods.isPopupMenu())
+        showSampleMenu();
 }
 
-void AnyDrum001AudioProcessorEditor::mouseExit(const juce::MouseEvent& event)
+void AnyDrum001AudioProcessorEditor::displayRefreshed()
 {
+    //with the host stopped, or only silence coming in, nothing is repainted at all
+    if (pullEnvelope())
+        repaintGraph();
 }
 
 bool AnyDrum001AudioProcessorEditor::isInterestedInFileDrag(const juce::StringArray& files)
 {
     for (auto file : files)
     {
-        if (file.containsIgnoreCase(".wav") || file.containsIgnoreCase(".mp3") || file.containsIgnoreCase(".aif") || file.containsIgnoreCase(".aiff"))
+        if (DrumSampleSet::isLoadableFile(juce::File(file)))
         {
             return true;
         }
@@ -297,7 +403,7 @@ void AnyDrum001AudioProcessorEditor::filesDropped(const juce::StringArray& files
         {
             audioProcessor.currentlyLoadedFile = file;
 
-            audioProcessor.loadFileIntoTransport();
+            audioProcessor.loadSampleFile();
         }
     }
 
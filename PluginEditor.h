@@ -10,6 +10,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "DiagnosticsPanel.h"
 
 //==============================================================================
 
@@ -82,8 +83,7 @@ public:
     void timerCallback() override;
     void paintHistogram(juce::Graphics&);
 
-    void mouseEnter(const juce::MouseEvent& event) override;
-    void mouseExit(const juce::MouseEvent& event) override;
+    void mouseDown(const juce::MouseEvent& event) override;
 
     bool isInterestedInFileDrag(const juce::StringArray& files) override;
     void filesDropped(const juce::StringArray& files, int x, int y) override;
@@ -102,7 +102,27 @@ private:
 
     juce::AudioProcessorValueTreeState& valueTreeState;
 
-    int rectArray[554] = { 0 };
+    static constexpr int graphWidth = 554;
+    static constexpr int graphHeight = 205;
+
+    void renderBackground();
+    void displayRefreshed();
+    bool pullEnvelope();
+    void repaintGraph();
+    void updateFileName();
+    void showSampleMenu();
+
+    void showValueLabelWhileDragging(juce::Slider& slider, juce::Label& label, int numDecimals);
+    void updateValueLabel(juce::Slider& slider, juce::Label& label, int numDecimals);
+
+    //everything that never changes, drawn once
+    juce::Image mBackground;
+
+    //the histogram, one column per envelope point. it's circular, so a new point only redraws its own
+    //column and paint() blits it in two pieces. mHistoryPosition is the oldest column.
+    juce::Image mGraphImage;
+    int mHistoryPosition = 0;
+    int mNumQuietColumns = graphWidth;//since the last column with anything in it, so a flat graph isn't redrawn
     int margin = 12;
 
     CustomLookAndFeel customLnF;
@@ -117,6 +137,11 @@ private:
     juce::TextButton mOpenButton{ "" };
 
     juce::Label mFileNameLabel;
+    juce::ComboBox mSlotBox;
+    juce::TooltipWindow mTooltipWindow{ this };
+
+    juce::TextButton mDiagnosticsButton{ "i" };
+    DiagnosticsPanel mDiagnosticsPanel;
 
     juce::Slider mTriggerToggleSlider;
 
@@ -142,5 +167,8 @@ private:
 
     AnyDrum001AudioProcessor& audioProcessor;
 
+    //redraws the graph in step with the display, and only when there's something new to show
+    juce::VBlankAttachment mVBlankAttachment{ this, [this] { displayRefreshed(); } };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnyDrum001AudioProcessorEditor)
 };
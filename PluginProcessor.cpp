@@ -40,6 +40,10 @@ AnyDrum001AudioProcessor::AnyDrum001AudioProcessor()
                                                         "Offset",
                                                         juce::NormalisableRange<float>(0.f, 6000.f, 1.f),
                                                         512.f),
+            std::make_unique<juce::AudioParameterFloat>("window",
+                                                        "Window",
+                                                        juce::NormalisableRange<float>(16.f, 4096.f, 1.f),
+                                                        256.f),
             std::make_unique<juce::AudioParameterFloat>("mask",
                                                         "Mask",
                                                         juce::NormalisableRange<float>(1000.f, 50000.f, 1.f),
@@ -48,6 +52,52 @@ AnyDrum001AudioProcessor::AnyDrum001AudioProcessor()
                                                         "Output",
                                                         0.0f,
                                                         2.0f,
+                                                        1.0f),
+            std::make_unique<juce::AudioParameterInt>("polyphony",
+                                                      "Polyphony",
+                                                      1,
+                                                      VoicePool::maxVoices,
+                                                      8),
+            std::make_unique<juce::AudioParameterChoice>("stealing",
+                                                         "Voice Stealing",
+                                                         juce::StringArray{ "Oldest", "Quietest", "Ignore New" },
+                                                         0),
+            std::make_unique<juce::AudioParameterBool>("lookahead",
+                                                       "Lookahead",
+                                                       false),
+            std::make_unique<juce::AudioParameterChoice>("channelmode",
+                                                         "Channel Mode",
+                                                         juce::StringArray{ "Linked (Max)", "Linked (Sum)", "Per Channel" },
+                                                         0),
+            std::make_unique<juce::AudioParameterChoice>("detector",
+                                                         "Detector",
+                                                         juce::StringArray{ "Peak", "Spectral Flux" },
+                                                         0),
+            std::make_unique<juce::AudioParameterChoice>("resampler",
+                                                         "Resampler",
+                                                         juce::StringArray{ "Linear", "Lagrange", "Windowed Sinc" },
+                                                         2),
+            std::make_unique<juce::AudioParameterChoice>("outputmode",
+                                                         "Output Mode",
+                                                         juce::StringArray{ "Audio", "Audio + MIDI", "MIDI Only" },
+                                                         0),
+            std::make_unique<juce::AudioParameterInt>("midinote",
+                                                      "MIDI Note",
+                                                      0,
+                                                      127,
+                                                      36),
+            std::make_unique<juce::AudioParameterChoice>("startmode",
+                                                         "Sample Start",
+                                                         juce::StringArray{ "Onset", "Manual" },
+                                                         0),
+            std::make_unique<juce::AudioParameterFloat>("starttime",
+                                                        "Sample Start Time",
+                                                        juce::NormalisableRange<float>(0.f, 50.f, 0.1f),
+                                                        0.f),
+            std::make_unique<juce::AudioParameterFloat>("mix",
+                                                        "Mix",
+                                                        0.0f,
+                                                        1.0f,
                                                         1.0f)
         })
 #endif
@@ -56,17 +106,40 @@ AnyDrum001AudioProcessor::AnyDrum001AudioProcessor()
     mGain = parameters.getRawParameterValue("gain");
     mThreshold = parameters.getRawParameterValue("threshold");
     mOffsetLimit = parameters.getRawParameterValue("offset");
+    mWindowLength = parameters.getRawParameterValue("window");
     mMaskLimit = parameters.getRawParameterValue("mask");
     mOutputVol = parameters.getRawParameterValue("output");
+    mPolyphony = parameters.getRawParameterValue("polyphony");
+    mStealing = parameters.getRawParameterValue("stealing");
+    mLookahead = parameters.getRawParameterValue("lookahead");
+    mChannelMode = parameters.getRawParameterValue("channelmode");
+    mDetectorMethod = parameters.getRawParameterValue("detector");
+    mResampler = parameters.getRawParameterValue("resampler");
+    mOutputMode = parameters.getRawParameterValue("outputmode");
+    mMidiNote = parameters.getRawParameterValue("midinote");
+    mStartMode = parameters.getRawParameterValue("startmode");
+    mStartTime = parameters.getRawParameterValue("starttime");
+    mMix = parameters.getRawParameterValue("mix");
 
     parameters.state = juce::ValueTree("savedParams");
 
-    formatManager.registerBasicFormats();
+    parameters.addParameterListener("offset", this);
+    parameters.addParameterListener("lookahead", this);
+    parameters.addParameterListener("detector", this);
+    parameters.addParameterListener("resampler", this);
+
+    mLoader.addChangeListener(this);
 }
 
 AnyDrum001AudioProcessor::~AnyDrum001AudioProcessor()
 {
-    transport.setSource(nullptr);
+    parameters.removeParameterListener("offset", this);
+    parameters.removeParameterListener("lookahead", this);
+    parameters.removeParameterListener("detector", this);
+    parameters.removeParameterListener("resampler", this);
+
+    mLoader.removeChangeListener(this);
+    cancelPendingUpdate();
 }
 
 //==============================================================================
@@ -134,61 +207,124 @@ void AnyDrum001AudioProcessor::changeProgramName (int index, const juce::String&
 //==============================================================================
 void AnyDrum001AudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    transport.prepareToPlay(samplesPerBlock, sampleRate);
+    mVoices.prepare(sampleRate);
+    mDetector.prepare(samplesPerBlock, static_cast<int>(parameters.getParameterRange("window").end));
+    mMidiOutput.prepare(sampleRate);
+    mEnvelope.prepare(sampleRate);
+
+    mInputGain.reset(sampleRate, 0.02);
+    mInputGain.setCurrentAndTargetValue(*mGain);
+    mOutputGain.reset(sampleRate, 0.02);
+    mOutputGain.setCurrentAndTargetValue(*mOutputVol);
+    mWetGain.reset(sampleRate, 0.02);
+    mWetGain.setCurrentAndTargetValue(*mMix);
+    mDryGain.reset(sampleRate, 0.02);
+    mDryGain.setCurrentAndTargetValue(1.0f - *mMix);
+    mGainRamp.assign(static_cast<size_t>(juce::jmax(1, samplesPerBlock)), 0.0f);
+    mSamplesProcessed = 0;
+
+    auto maxLatency = juce::jmax(static_cast<int>(parameters.getParameterRange("offset").end),
+                                 SpectralFluxDetector::latencySamples);
+    mLookaheadDelay.prepare(getTotalNumInputChannels(), maxLatency, samplesPerBlock);
+
+    //the dry path is handled a grid step at a time, so its buffer never needs to grow with the host's blocks
+    mDryDelay.prepare(getTotalNumInputChannels(), maxLatency, parameterGridSize);
+    mDryBuffer.setSize(juce::jmax(1, getTotalNumInputChannels()), parameterGridSize);
+
+    updateLatency();
+
+    //a set made for another rate keeps playing through the voices' interpolation until the new one lands
+    updatePlaybackFormat();
 }
 
 //==============================================================================
-void AnyDrum001AudioProcessor::openButtonClicked()
+int AnyDrum001AudioProcessor::getDetectionLatencySamples() const
 {
-    juce::FileChooser chooser("Choose a file", juce::File::getSpecialLocation(juce::File::userDesktopDirectory), "*.wav; *.mp3; *.aif; *.aiff", true, false);
+    if (static_cast<int>(*mDetectorMethod) == static_cast<int>(TransientDetector::Method::spectralFlux))
+        return SpectralFluxDetector::latencySamples;
 
-    if (chooser.browseForFileToOpen())
-    {
-        juce::File myFile;
+    //the amplitude follows the signal sample by sample, so only the offset count holds a hit back. the frame
+    //that crosses the threshold is already the first one counted, so a hit fires offset - 1 frames after it.
+    return juce::jmax(0, static_cast<int>(*mOffsetLimit) - 1);
+}
 
-        myFile = chooser.getResult();
+void AnyDrum001AudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    //this can arrive on the audio thread, and the host must only be told about latency from the message thread
+    triggerAsyncUpdate();
+}
 
-        currentlyLoadedFile = myFile;
+void AnyDrum001AudioProcessor::handleAsyncUpdate()
+{
+    updateLatency();
+    updatePlaybackFormat();
+}
 
-        juce::AudioFormatReader* reader = formatManager.createReaderFor(myFile);
+void AnyDrum001AudioProcessor::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    releaseRestoredEmbedding();
+}
 
-        if (reader != nullptr)
-        {
-            std::unique_ptr<juce::AudioFormatReaderSource> tempSource(new juce::AudioFormatReaderSource(reader, true));
+void AnyDrum001AudioProcessor::updateLatency()
+{
+    auto isLookahead = *mLookahead >= 0.5f;
+    auto latency = isLookahead ? getDetectionLatencySamples() : 0;
 
-            transport.setSource(tempSource.get(), 0, nullptr, reader->sampleRate);
-            transport.stop();
-            transport.setPosition(0.0);
+    mLookaheadSamples = latency;
+    setLatencySamples(latency);
 
-            playSource.reset(tempSource.release());
-        }
-    }
+    //with lookahead the input is already held back by the detection latency, otherwise the dry path holds it back itself
+    mDryDelaySamples = isLookahead ? 0 : getDetectionLatencySamples();
 }
 
-void AnyDrum001AudioProcessor::playButtonClicked()
+void AnyDrum001AudioProcessor::updatePlaybackFormat()
 {
-    if (*isTriggerOn == 1)
+    if (getSampleRate() > 0.0)
+        mLoader.setPlaybackFormat(getSampleRate(), static_cast<DrumSample::Resampler>(static_cast<int>(*mResampler)));
+}
+
+//==============================================================================
+void AnyDrum001AudioProcessor::openButtonClicked()
+{
+    juce::FileChooser chooser("Choose a file, folder or sample set", juce::File::getSpecialLocation(juce::File::userDesktopDirectory), "*.wav; *.mp3; *.aif; *.aiff; *.anydrum", true, false);
+
+    if (chooser.browseForFileOrDirectory())
     {
-        transport.setGain(0.5);//(1.0);
-        transport.setPosition(0.0);
-        transport.start();
+        currentlyLoadedFile = chooser.getResult();
+
+        loadSampleFile();
     }
 }
 
-void AnyDrum001AudioProcessor::playFile()
+void AnyDrum001AudioProcessor::playButtonClicked()
 {
-    if (*isTriggerOn == 1)
+    //voices may only be started from the audio thread, so just flag it for the next block
+    mAuditionRequested = true;
+}
+
+void AnyDrum001AudioProcessor::playFile(int sampleOffset, float velocity, int channel, double startSeconds)
+{
+    if (*isTriggerOn == 1 && mAudioKit != nullptr)
     {
-        transport.setGain(mOffsetAmp);
-        transport.setPosition(0.0);
-        transport.start();
+        auto slot = mAudioKit->findSlotForChannel(channel);
+
+        if (slot < 0)
+            return;
+
+        if (auto* sample = mAudioKit->getSet(slot)->selectSample(velocity))
+            mVoices.startVoice(*sample, velocity, sampleOffset, channel, slot, sample->getStartPosition(startSeconds));//the hit starts at the exact sample it was detected on
     }
 }
 
 //==============================================================================
 void AnyDrum001AudioProcessor::releaseResources()
 {
-    transport.releaseResources();
+    mVoices.stopAllVoices();
+    mMidiOutput.reset();
+
+    mAudioKit = nullptr;
+    mRetiringKit = nullptr;
+    mLoader.audioThreadStopped();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -198,12 +334,10 @@ bool AnyDrum001AudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    //anything from mono up to one channel per kit slot, so a whole multitracked kit can go through one instance
+    auto numChannels = layouts.getMainOutputChannelSet().size();
+
+    if (numChannels < 1 || numChannels > juce::jmin(DrumKit::numSlots, TransientDetector::maxChannels))
         return false;
 
     // This checks if the input layout matches the output layout
@@ -219,6 +353,8 @@ bool AnyDrum001AudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
 
 void AnyDrum001AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    auto startTicks = juce::Time::getHighResolutionTicks();
+
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -226,88 +362,217 @@ void AnyDrum001AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    auto numSamples = buffer.getNumSamples();
+
+    //parameters are read once per sub-block of a fixed grid, counted from prepareToPlay(), so a setting that
+    //changes mid-render lands on the same sample whatever the host's buffer size. nothing below reads them per sample.
+    auto params = getParameterSnapshot();
+
+    mVoices.setPolyphony(params.polyphony);
+    mVoices.setStealingPolicy(params.stealingPolicy);
+
+    updateAudioKit();
+
+    if (mAuditionRequested.exchange(false) && params.triggerOn && mAudioKit != nullptr)
     {
-        auto* channelData = buffer.getWritePointer(channel);
+        auto slot = mAudioKit->findSlotForChannel(mSelectedSlot);
 
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)//working on a sample-by-sample basis
+        if (slot >= 0)
+            if (auto* sample = mAudioKit->getSet(slot)->selectSample(0.5f))
+                mVoices.startVoice(*sample, 0.5f, 0, -1, slot, sample->getStartPosition(params.sampleStartSeconds));
+    }
+
+    mTelemetry.addInputPeak(buffer.getMagnitude(0, numSamples));
+
+    auto blockPosition = mSamplesProcessed;
+
+    auto getSubBlockLength = [blockPosition, numSamples](int start)
+    {
+        auto gridPosition = static_cast<int>((blockPosition + start) % parameterGridSize);
+        return juce::jmin(numSamples - start, parameterGridSize - gridPosition);
+    };
+
+    for (int start = 0; start < numSamples;)
+    {
+        auto subBlockLength = getSubBlockLength(start);
+
+        if (start > 0)
+            params = getParameterSnapshot();
+
+        //input volume
+        mInputGain.setTargetValue(params.gain);
+        applySmoothedGain(mInputGain, buffer, totalNumInputChannels, start, subBlockLength);
+
+        //triggering according to sensitivity variables, advancing the detectors once per frame
+        mDetector.setChannelMode(params.channelMode);
+        mDetector.setMethod(params.method);
+
+        auto numHits = mDetector.process(buffer, start, subBlockLength, params.detector);
+        auto numNotesOutOfRange = 0;
+
+        for (int i = 0; i < numHits; ++i)
         {
-            channelData[sample] = channelData[sample] * *mGain;//input volume
+            const auto& hit = mDetector.getHit(i);
 
-            //determining mAmplitude
-            float singleSample = std::abs(buffer.getSample(channel, sample));
+            mEnvelope.markTrigger(hit.sampleOffset);
 
-            if (singleSample > mMaxPeak)
-            {
-                mMaxPeak = singleSample;//making maxPeak the maximum of the 256 samples that we're going through
-            }
+            if (params.outputMode != OutputMode::midiOnly)
+                playFile(hit.sampleOffset, hit.amplitude, hit.channel, params.sampleStartSeconds);
 
-            ++mSampleCounter;
+            //one note per kit piece. a piece whose note would pass 127 is left out rather than doubled up on another's.
+            if (params.triggerOn && params.outputMode != OutputMode::audio)
+                if (! mMidiOutput.addHit(midiMessages, params.midiNote + juce::jmax(0, hit.channel), hit.amplitude, hit.sampleOffset))
+                    ++numNotesOutOfRange;
+        }
 
-            if (mSampleCounter == mDetectionLength)
-            {
-                mAmplitude = mMaxPeak;
-                mMaxPeak = 0.0;
-                mSampleCounter = 0;
-            }
+        mTelemetry.addTriggers(numHits, mDetector.getNumMasked());
+        mTelemetry.addNotesOutOfRange(numNotesOutOfRange);
 
-            //triggering according to sensitivity variables
+        mSamplesProcessed += subBlockLength;
+        start += subBlockLength;
+    }
 
-            if (*mThreshold < mAmplitude)
-            {
-                //finding mOffsetPeak
-                if (singleSample > mOffsetPeak)
-                {
-                    mOffsetPeak = singleSample;
-                }
+    mMidiOutput.finishBlock(midiMessages, numSamples);
 
-                ++mOffsetCounter;
+    //the level the detectors saw, before the lookahead delay and the sample player change the buffer
+    mEnvelope.pushBlock(buffer, totalNumInputChannels, numSamples);
+    mOnsetEngineCost = static_cast<float>(mDetector.getFrameCostMicroseconds());
 
-                if (mOffsetCounter >= *mOffsetLimit)
-                {
-                    mOffsetAmp = mOffsetPeak;
-                    mOffsetPeak = 0.0;
-
-                    if (mMaskCounter < *mMaskLimit)
-                    {
-                        if (isTriggering == 0)
-                        {
-                            isTriggering = 1;
-                            playFile();
-                            mMaskCounter = 0;
-                        }
-                    }
-                    mOffsetCounter = 0;
-                }
-            }
-            else
-            {
-                mOffsetCounter = 0;
-            }
+    //in lookahead mode the whole signal path runs late by the detection latency, which the host compensates for
+    mLookaheadDelay.process(buffer, numSamples, mLookaheadSamples);
+
+    auto isReplacing = params.triggerOn && params.outputMode != OutputMode::midiOnly;
 
-            ++mMaskCounter;
+    //with the trigger off, or only sending midi, the input passes through and no voices run
+    if (! isReplacing)
+        mVoices.stopAllVoices();
 
-            if (mMaskCounter >= *mMaskLimit)
+    //the dry blend and the output volume, stepping their targets on the same grid as everything else
+    for (int start = 0; start < numSamples;)
+    {
+        auto subBlockLength = getSubBlockLength(start);
+
+        //the dry line is always fed, so turning the mix down never plays stale audio
+        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+            mDryBuffer.copyFrom(channel, 0, buffer, channel, start, subBlockLength);
+
+        mDryDelay.process(mDryBuffer, subBlockLength, mDryDelaySamples);
+
+        if (isReplacing)
+        {
+            //turn the sample player on; mutes all previous input signal
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                buffer.clear(channel, start, subBlockLength);
+
+            mVoices.renderNextBlock(buffer, start, subBlockLength);
+
+            auto mix = mMix->load();
+
+            mWetGain.setTargetValue(mix);
+            applySmoothedGain(mWetGain, buffer, totalNumInputChannels, start, subBlockLength);
+
+            //the delayed input lines up with the hits it set off, so the blend stays in phase
+            mDryGain.setTargetValue(1.0f - mix);
+
+            if (mDryGain.isSmoothing() || mDryGain.getTargetValue() > 0.0f)
             {
-                isTriggering = 0;
-                mMaskCounter = 0;
+                applySmoothedGain(mDryGain, mDryBuffer, totalNumInputChannels, 0, subBlockLength);
+
+                for (int channel = 0; channel < totalNumInputChannels; ++channel)
+                    buffer.addFrom(channel, start, mDryBuffer, channel, 0, subBlockLength);
             }
         }
+
+        mOutputGain.setTargetValue(*mOutputVol);
+        applySmoothedGain(mOutputGain, buffer, totalNumInputChannels, start, subBlockLength);
+
+        start += subBlockLength;
+    }
+
+    //once the old kit's voices have faded it can be handed back to the loader thread to free
+    if (mRetiringKit != nullptr)
+    {
+        mRetireCountdown -= numSamples;
+
+        if (mRetireCountdown <= 0)
+            mRetiringKit = nullptr;
     }
 
-    if (*isTriggerOn == 1)
+    mLoader.audioThreadFinishedBlock(mAudioKit, mRetiringKit);
+
+    mTelemetry.recordBlock(startTicks, numSamples, getSampleRate());
+}
+
+void AnyDrum001AudioProcessor::updateAudioKit() noexcept
+{
+    auto* latestKit = mLoader.getKitForAudioThread();
+
+    //a newer kit waits until the last one's fade has finished, so only one old kit is ever still being read.
+    //the fade is a few dozen samples, and the loader keeps the current kit alive for as long as we report it.
+    if (latestKit == mAudioKit || mRetiringKit != nullptr)
+        return;
+
+    //only the slots that actually changed lose their ringing hits
+    if (mAudioKit != nullptr)
+        for (int slot = 0; slot < DrumKit::numSlots; ++slot)
+            if (mAudioKit->getSet(slot) != latestKit->getSet(slot))
+                mVoices.fadeOutSlot(slot);
+
+    mRetiringKit = mAudioKit;
+    mRetireCountdown = mVoices.getFadeLength();
+    mAudioKit = latestKit;
+}
+
+AnyDrum001AudioProcessor::ParameterSnapshot AnyDrum001AudioProcessor::getParameterSnapshot() const noexcept
+{
+    ParameterSnapshot params;
+
+    params.triggerOn = *isTriggerOn == 1;
+    params.gain = *mGain;
+
+    params.detector.threshold = *mThreshold;
+    params.detector.windowLength = static_cast<int>(*mWindowLength);
+    params.detector.offsetLength = static_cast<int>(*mOffsetLimit);
+    params.detector.maskLength = static_cast<int>(*mMaskLimit);
+    params.channelMode = static_cast<TransientDetector::ChannelMode>(static_cast<int>(*mChannelMode));
+    params.method = static_cast<TransientDetector::Method>(static_cast<int>(*mDetectorMethod));
+
+    params.polyphony = static_cast<int>(*mPolyphony);
+    params.stealingPolicy = static_cast<VoicePool::StealingPolicy>(static_cast<int>(*mStealing));
+
+    params.outputMode = static_cast<OutputMode>(static_cast<int>(*mOutputMode));
+    params.midiNote = static_cast<int>(*mMidiNote);
+
+    params.sampleStartSeconds = static_cast<int>(*mStartMode) == 0 ? -1.0 : static_cast<double>(*mStartTime) * 0.001;
+
+    return params;
+}
+
+void AnyDrum001AudioProcessor::applySmoothedGain(juce::SmoothedValue<float>& gain, juce::AudioBuffer<float>& buffer, int numChannels, int startSample, int numSamples) noexcept
+{
+    if (! gain.isSmoothing())
     {
-        transport.getNextAudioBlock(juce::AudioSourceChannelInfo(buffer));//turn the sample player on; mutes all previous input signal
+        auto constantGain = gain.getTargetValue();
+
+        if (constantGain != 1.0f)
+            for (int channel = 0; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel, startSample), constantGain, numSamples);
+
+        return;
     }
 
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    //render the ramp once, then apply it to every channel with one vector multiply each
+    auto rampSize = static_cast<int>(mGainRamp.size());
+
+    for (int start = 0; start < numSamples; start += rampSize)
     {
-        auto* channelData = buffer.getWritePointer(channel);
+        auto numToApply = juce::jmin(rampSize, numSamples - start);
 
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-        {
-            channelData[sample] = channelData[sample] * *mOutputVol;//output volume
-        }
+        for (int i = 0; i < numToApply; ++i)
+            mGainRamp[static_cast<size_t>(i)] = gain.getNextValue();
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel, startSample + start), mGainRamp.data(), numToApply);
     }
 }
 
@@ -335,10 +600,30 @@ void AnyDrum001AudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     xml->setAttribute("gain", *mGain);
     xml->setAttribute("threshold", *mThreshold);
     xml->setAttribute("offset", *mOffsetLimit);
+    xml->setAttribute("window", *mWindowLength);
     xml->setAttribute("mask", *mMaskLimit);
     xml->setAttribute("output", *mOutputVol);
-
-    xml->setAttribute("audiofile", currentlyLoadedFile.getFullPathName());
+    xml->setAttribute("polyphony", *mPolyphony);
+    xml->setAttribute("stealing", *mStealing);
+    xml->setAttribute("lookahead", *mLookahead);
+    xml->setAttribute("channelmode", *mChannelMode);
+    xml->setAttribute("detector", *mDetectorMethod);
+    xml->setAttribute("resampler", *mResampler);
+    xml->setAttribute("outputmode", *mOutputMode);
+    xml->setAttribute("midinote", *mMidiNote);
+    xml->setAttribute("startmode", *mStartMode);
+    xml->setAttribute("starttime", *mStartTime);
+    xml->setAttribute("mix", *mMix);
+
+    //slot 1 keeps the old attribute name, so sessions saved before kits still open
+    for (int slot = 0; slot < DrumKit::numSlots; ++slot)
+        xml->setAttribute(getSlotAttributeName(slot), mSlotFiles[static_cast<size_t>(slot)].getFullPathName());
+
+    xml->setAttribute("selectedslot", mSelectedSlot.load());
+    xml->setAttribute("embedsamples", mEmbedSamples.load());
+
+    if (mEmbedSamples)
+        xml->addChildElement(createEmbeddedSamplesXml().release());
 
     copyXmlToBinary(*xml, destData);
 
@@ -356,20 +641,62 @@ void AnyDrum001AudioProcessor::setStateInformation (const void* data, int sizeIn
     {
         if (theParams->hasTagName(parameters.state.getType()))
         {
+            //taken out first, so the embedded audio doesn't end up in the parameter tree
+            std::unique_ptr<juce::XmlElement> embedded(theParams->getChildByName("EmbeddedSamples"));
+
+            if (embedded != nullptr)
+                theParams->removeChildElement(embedded.get(), false);
+
             parameters.state = juce::ValueTree::fromXml(*theParams);
 
             *isTriggerOn = theParams->getDoubleAttribute("toggle");
             *mGain = theParams->getDoubleAttribute("gain");
             *mThreshold = theParams->getDoubleAttribute("threshold");
             *mOffsetLimit = theParams->getDoubleAttribute("offset");
+            *mWindowLength = theParams->getDoubleAttribute("window", 256.0);
             *mMaskLimit = theParams->getDoubleAttribute("mask");
             *mOutputVol = theParams->getDoubleAttribute("output");
+            *mPolyphony = theParams->getDoubleAttribute("polyphony", 8.0);
+            *mStealing = theParams->getDoubleAttribute("stealing", 0.0);
+            *mLookahead = theParams->getDoubleAttribute("lookahead", 0.0);
+            *mChannelMode = theParams->getDoubleAttribute("channelmode", 0.0);
+            *mDetectorMethod = theParams->getDoubleAttribute("detector", 0.0);
+            *mResampler = theParams->getDoubleAttribute("resampler", 2.0);
+            *mOutputMode = theParams->getDoubleAttribute("outputmode", 0.0);
+            *mMidiNote = theParams->getDoubleAttribute("midinote", 36.0);
+            *mStartMode = theParams->getDoubleAttribute("startmode", 0.0);
+            *mStartTime = theParams->getDoubleAttribute("starttime", 0.0);
+            *mMix = theParams->getDoubleAttribute("mix", 1.0);
+
+            mEmbedSamples = theParams->getBoolAttribute("embedsamples", false);
+
+            triggerAsyncUpdate();
+
+            //only unpacked here, the decoding is left to the loader thread
+            auto embeddedAudio = std::make_shared<DrumSampleSet::EmbeddedAudio>();
+
+            if (embedded != nullptr)
+                for (auto* audioXml : embedded->getChildWithTagNameIterator("Audio"))
+                    (*embeddedAudio)[audioXml->getStringAttribute("hash")].fromBase64Encoding(audioXml->getStringAttribute("data"));
 
-            currentlyLoadedFile = juce::File::createFileWithoutCheckingPath(theParams->getStringAttribute("audiofile"));
-            if (currentlyLoadedFile.existsAsFile())
             {
-                loadFileIntoTransport();
+                //kept before anything is queued, so the first set to be published can't look for it too soon
+                const juce::ScopedLock sl(mRestoredEmbeddingLock);
+                mRestoredEmbedding = std::move(embedded);
+
+                for (int slot = 0; slot < DrumKit::numSlots; ++slot)
+                {
+                    auto& slotFile = mSlotFiles[static_cast<size_t>(slot)];
+                    slotFile = juce::File::createFileWithoutCheckingPath(theParams->getStringAttribute(getSlotAttributeName(slot)));
+
+                    if (auto* embeddedSet = findEmbeddedSet(mRestoredEmbedding.get(), slot))
+                        mLoader.loadEmbeddedAsync(slot, *embeddedSet, embeddedAudio);
+                    else if (slotFile.exists())
+                        mLoader.loadAsync(slot, slotFile);
+                }
             }
+
+            setSelectedSlot(theParams->getIntAttribute("selectedslot", 0));
         }
     }
 //    */
@@ -382,18 +709,150 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
     return new AnyDrum001AudioProcessor();
 }
 
-void AnyDrum001AudioProcessor::loadFileIntoTransport()
+void AnyDrum001AudioProcessor::loadSampleFile()
+{
+    mSlotFiles[static_cast<size_t>(mSelectedSlot.load())] = currentlyLoadedFile;
+
+    //decoding happens on the loader thread, so neither the editor nor the host's session load has to wait for it
+    mLoader.loadAsync(mSelectedSlot, currentlyLoadedFile);
+}
+
+bool AnyDrum001AudioProcessor::loadSampleFileNow()
+{
+    mSlotFiles[static_cast<size_t>(mSelectedSlot.load())] = currentlyLoadedFile;
+
+    return mLoader.loadNow(mSelectedSlot, currentlyLoadedFile);
+}
+
+void AnyDrum001AudioProcessor::setSelectedSlot(int slot)
+{
+    mSelectedSlot = juce::jlimit(0, DrumKit::numSlots - 1, slot);
+    currentlyLoadedFile = mSlotFiles[static_cast<size_t>(mSelectedSlot.load())];
+}
+
+juce::String AnyDrum001AudioProcessor::getLoadedSampleDescription() const
+{
+    if (mLoader.isLoading())
+        return "Loading " + currentlyLoadedFile.getFileName() + "...";
+
+    auto kit = mLoader.getLatestKit();
+    auto* sampleSet = kit != nullptr ? kit->getSet(mSelectedSlot) : nullptr;
+
+    return sampleSet != nullptr ? sampleSet->getDescription() : juce::String();
+}
+
+bool AnyDrum001AudioProcessor::setParameterFromText(const juce::String& parameterID, const juce::String& text)
 {
-    juce::AudioFormatReader* reader = formatManager.createReaderFor(currentlyLoadedFile);
+    auto* parameter = parameters.getParameter(parameterID);
 
-    if (reader != nullptr)
+    if (parameter == nullptr)
+        return false;
+
+    parameter->setValueNotifyingHost(parameter->getValueForText(text));
+    return true;
+}
+
+juce::String AnyDrum001AudioProcessor::getSlotAttributeName(int slot)
+{
+    return slot == 0 ? juce::String("audiofile") : "audiofile" + juce::String(slot + 1);
+}
+
+std::unique_ptr<juce::XmlElement> AnyDrum001AudioProcessor::createEmbeddedSamplesXml()
+{
+    auto embedded = std::make_unique<juce::XmlElement>("EmbeddedSamples");
+    auto kit = mLoader.getLatestKit();
+
+    DrumSampleSet::EmbeddedAudio audio;
+    juce::StringArray restoredHashes;
+
+    const juce::ScopedLock sl(mRestoredEmbeddingLock);
+
+    for (int slot = 0; slot < DrumKit::numSlots; ++slot)
+    {
+        auto& slotFile = mSlotFiles[static_cast<size_t>(slot)];
+        auto* set = kit != nullptr ? kit->getSet(slot) : nullptr;
+        std::unique_ptr<juce::XmlElement> layout;
+
+        if (set != nullptr && set->getSource() == slotFile)
+        {
+            layout = set->createEmbeddedXml(mLoader.getSamplePool(), audio);
+        }
+        else if (auto* restored = findEmbeddedSet(mRestoredEmbedding.get(), slot))
+        {
+            //restored from the session but not decoded yet, so it goes back in as it came
+            if (restored->getStringAttribute("source") == slotFile.getFullPathName())
+            {
+                layout = std::make_unique<juce::XmlElement>(*restored);
+
+                for (auto* layerXml : restored->getChildWithTagNameIterator("Layer"))
+                    for (auto* sampleXml : layerXml->getChildWithTagNameIterator("Sample"))
+                        restoredHashes.addIfNotAlreadyThere(sampleXml->getStringAttribute("hash"));
+            }
+        }
+
+        if (layout != nullptr)
+        {
+            layout->setAttribute("slot", slot);
+            embedded->addChildElement(layout.release());
+        }
+    }
+
+    //identical samples in different slots are only stored once
+    for (auto& hashAndData : audio)
+    {
+        auto* audioXml = embedded->createNewChildElement("Audio");
+        audioXml->setAttribute("hash", hashAndData.first);
+        audioXml->setAttribute("data", hashAndData.second.toBase64Encoding());
+    }
+
+    if (mRestoredEmbedding != nullptr)
+        for (auto* audioXml : mRestoredEmbedding->getChildWithTagNameIterator("Audio"))
+            if (restoredHashes.contains(audioXml->getStringAttribute("hash")) && audio.count(audioXml->getStringAttribute("hash")) == 0)
+                embedded->addChildElement(new juce::XmlElement(*audioXml));
+
+    return embedded;
+}
+
+void AnyDrum001AudioProcessor::releaseRestoredEmbedding()
+{
+    const juce::ScopedLock sl(mRestoredEmbeddingLock);
+
+    if (mRestoredEmbedding == nullptr)
+        return;
+
+    auto kit = mLoader.getLatestKit();
+
+    //kept until every set it holds has been decoded and published, since a set that never made it
+    //(or hasn't yet) can only be saved again from here
+    for (auto* setXml : mRestoredEmbedding->getChildWithTagNameIterator("Set"))
     {
-        std::unique_ptr<juce::AudioFormatReaderSource> tempSource(new juce::AudioFormatReaderSource(reader, true));
+        auto slot = setXml->getIntAttribute("slot", -1);
+        auto source = setXml->getStringAttribute("source");
 
-        transport.setSource(tempSource.get(), 0, nullptr, reader->sampleRate);
-        transport.stop();
-        transport.setPosition(0.0);
+        if (! juce::isPositiveAndBelow(slot, DrumKit::numSlots))
+            continue;
 
-        playSource.reset(tempSource.release());
+        //a slot that's been given something else since doesn't need what the session had in it
+        if (mSlotFiles[static_cast<size_t>(slot)].getFullPathName() != source)
+            continue;
+
+        auto* set = kit != nullptr ? kit->getSet(slot) : nullptr;
+
+        if (set == nullptr || set->getEmbeddedLayout() == nullptr || set->getSource().getFullPathName() != source)
+            return;
     }
+
+    mRestoredEmbedding = nullptr;
+}
+
+const juce::XmlElement* AnyDrum001AudioProcessor::findEmbeddedSet(const juce::XmlElement* embeddedSamples, int slot)
+{
+    if (embeddedSamples == nullptr)
+        return nullptr;
+
+    for (auto* setXml : embeddedSamples->getChildWithTagNameIterator("Set"))
+        if (setXml->getIntAttribute("slot", -1) == slot)
+            return setXml;
+
+    return nullptr;
 }
\ No newline at end of file
@@ -9,11 +9,21 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "SampleLoader.h"
+#include "VoicePool.h"
+#include "SampleDelay.h"
+#include "TransientDetector.h"
+#include "MidiTriggerOutput.h"
+#include "ProcessorTelemetry.h"
+#include "EnvelopeFifo.h"
 
 //==============================================================================
 /**
 */
-class AnyDrum001AudioProcessor  : public juce::AudioProcessor
+class AnyDrum001AudioProcessor  : public juce::AudioProcessor,
+                                  private juce::AudioProcessorValueTreeState::Listener,
+                                  private juce::AsyncUpdater,
+                                  private juce::ChangeListener
 {
 public:
     //==============================================================================
@@ -54,19 +64,92 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
 
     //==============================================================================
-    std::atomic<float> mAmplitude;//a number between 0 and 1.
-
     //file player functions
     void openButtonClicked();
     void playButtonClicked();
-    void playFile();
+    void playFile(int sampleOffset, float velocity, int channel, double startSeconds = -1.0);
+
+    //queues currentlyLoadedFile, which may be a single sample, a folder of layers or a manifest,
+    //for decoding on the loader thread into the selected kit slot. the audio thread picks it up once it's ready.
+    void loadSampleFile();
+    juce::File currentlyLoadedFile;//the file in the selected slot
+
+    //each input channel plays the sample in its own slot in per-channel mode, falling back to the first slot.
+    //linked detection always plays the first slot.
+    void setSelectedSlot(int slot);
+    int getSelectedSlot() const noexcept                    { return mSelectedSlot; }
+
+    //decodes currentlyLoadedFile on the calling thread, ready for the next block. for offline rendering,
+    //where nothing can wait on the loader thread. call after prepareToPlay() so it comes out at the right rate.
+    bool loadSampleFileNow();
+
+    //saves the audio of every loaded set into the session, so it opens on machines without the files.
+    //restoring never reads the disk for an embedded set, and instances sharing a sample share its decode.
+    void setEmbedSamples(bool shouldEmbed) noexcept         { mEmbedSamples = shouldEmbed; }
+    bool getEmbedSamples() const noexcept                   { return mEmbedSamples; }
+
+    //layers, round-robins and memory use of the loaded set, or empty if nothing is loaded
+    juce::String getLoadedSampleDescription() const;
+
+    //how far behind the source transient a hit fires, for the current settings
+    int getDetectionLatencySamples() const;
 
-    void loadFileIntoTransport();
-    juce::File currentlyLoadedFile;
+    //sets a parameter from its text form, so choices can be given by name. returns false for an unknown id.
+    bool setParameterFromText(const juce::String& parameterID, const juce::String& text);
 
-    bool isTriggering{ 0 };
+    //time the spectral flux engine spends analysing each hop, zero in peak mode
+    float getOnsetEngineCostMicroseconds() const noexcept   { return mOnsetEngineCost; }
+
+    //the input envelope and the hits, one point per window of audio time. only the editor may read it.
+    EnvelopeFifo& getEnvelopeFifo() noexcept                { return mEnvelope; }
+
+    //block timing, trigger counts and input peak, readable from any thread without blocking the audio one
+    ProcessorTelemetry& getTelemetry() noexcept             { return mTelemetry; }
 
 private:
+    //==============================================================================
+    enum class OutputMode
+    {
+        audio = 0,
+        audioAndMidi,
+        midiOnly
+    };
+
+    struct ParameterSnapshot
+    {
+        bool triggerOn = false;
+        float gain = 1.0f;
+
+        DetectorSettings detector;
+        TransientDetector::ChannelMode channelMode = TransientDetector::ChannelMode::linkedMax;
+        TransientDetector::Method method = TransientDetector::Method::peak;
+
+        int polyphony = 8;
+        VoicePool::StealingPolicy stealingPolicy = VoicePool::StealingPolicy::oldest;
+
+        OutputMode outputMode = OutputMode::audio;
+        int midiNote = 36;
+
+        double sampleStartSeconds = -1.0;//negative to start every sample at its own onset
+    };
+
+    ParameterSnapshot getParameterSnapshot() const noexcept;
+    void updateAudioKit() noexcept;
+    void applySmoothedGain(juce::SmoothedValue<float>& gain, juce::AudioBuffer<float>& buffer, int numChannels, int startSample, int numSamples) noexcept;
+
+    //==============================================================================
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    void updateLatency();
+    void updatePlaybackFormat();
+
+    static juce::String getSlotAttributeName(int slot);
+
+    std::unique_ptr<juce::XmlElement> createEmbeddedSamplesXml();
+    void releaseRestoredEmbedding();//message thread only, once the loader has published something
+    static const juce::XmlElement* findEmbeddedSet(const juce::XmlElement* embeddedSamples, int slot);
+
     //==============================================================================
     juce::AudioProcessorValueTreeState parameters;
 
@@ -75,23 +158,62 @@ private:
     std::atomic<float>* mGain = nullptr;
     std::atomic<float>* mThreshold = nullptr;
     std::atomic<float>* mOffsetLimit = nullptr;
+    std::atomic<float>* mWindowLength = nullptr;
     std::atomic<float>* mMaskLimit = nullptr;
     std::atomic<float>* mOutputVol = nullptr;
+    std::atomic<float>* mPolyphony = nullptr;
+    std::atomic<float>* mStealing = nullptr;
+    std::atomic<float>* mLookahead = nullptr;
+    std::atomic<float>* mChannelMode = nullptr;
+    std::atomic<float>* mDetectorMethod = nullptr;
+    std::atomic<float>* mResampler = nullptr;
+    std::atomic<float>* mOutputMode = nullptr;
+    std::atomic<float>* mMidiNote = nullptr;
+    std::atomic<float>* mStartMode = nullptr;
+    std::atomic<float>* mStartTime = nullptr;
+    std::atomic<float>* mMix = nullptr;
 
     //==============================================================================
-    float mMaxPeak = 0.0;
-    int mSampleCounter = 0;
-    int mDetectionLength = 256;
+    static constexpr int parameterGridSize = 32;//samples between parameter reads
+    juce::int64 mSamplesProcessed = 0;
+
+    TransientDetector mDetector;
+    std::atomic<float> mOnsetEngineCost{ 0.0f };
+
+    juce::SmoothedValue<float> mInputGain;
+    juce::SmoothedValue<float> mOutputGain;
+    juce::SmoothedValue<float> mWetGain;
+    juce::SmoothedValue<float> mDryGain;
+    std::vector<float> mGainRamp;
+
+    SampleLoader mLoader;
+    std::array<juce::File, DrumKit::numSlots> mSlotFiles;
+    std::atomic<int> mSelectedSlot{ 0 };
+
+    std::atomic<bool> mEmbedSamples{ false };
+    //what the session embedded, until all of it has been published. hosts may save from any thread, even while restoring.
+    juce::CriticalSection mRestoredEmbeddingLock;
+    std::unique_ptr<juce::XmlElement> mRestoredEmbedding;
+
+    //only touched on the audio thread
+    DrumKit* mAudioKit = nullptr;
+    DrumKit* mRetiringKit = nullptr;//the previous kit, until its voices have faded out
+    int mRetireCountdown = 0;
+
+    VoicePool mVoices;
+    std::atomic<bool> mAuditionRequested{ false };
+
+    MidiTriggerOutput mMidiOutput;
 
-    float mOffsetPeak = 0.0;
-    float mOffsetAmp = 0.0;
-    int mOffsetCounter = 0;
-    int mMaskCounter = 0;
+    SampleDelay mLookaheadDelay;
+    std::atomic<int> mLookaheadSamples{ 0 };
 
-    juce::AudioFormatManager formatManager;
-    std::unique_ptr<juce::AudioFormatReaderSource> playSource;
+    SampleDelay mDryDelay;//the input for the dry/replacement blend, held back to line up with the hits
+    juce::AudioBuffer<float> mDryBuffer;
+    std::atomic<int> mDryDelaySamples{ 0 };
 
-    juce::AudioTransportSource transport;
+    EnvelopeFifo mEnvelope;
+    ProcessorTelemetry mTelemetry;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnyDrum001AudioProcessor)
@@ -0,0 +1,239 @@
+/*
+  ==============================================================================
+
+    ProcessorBenchmark.cpp
+
+  ==============================================================================
+*/
+
+#include "ProcessorBenchmark.h"
+#include "PluginProcessor.h"
+#include <iostream>
+
+namespace
+{
+    const int blockSizes[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+    const double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+    const int channelCounts[] = { 1, 2 };
+
+    const ProcessorBenchmark::Density densities[] = { { "silence", 0.0 },
+                                                      { "quarter", 2.0 },
+                                                      { "eighth", 4.0 },
+                                                      { "sixteenth", 8.0 },
+                                                      { "thirtysecond", 16.0 } };
+}
+
+//==============================================================================
+ProcessorBenchmark::ProcessorBenchmark(const Settings& settings)
+    : mSettings(settings)
+{
+}
+
+bool ProcessorBenchmark::run(const juce::File& outputFile)
+{
+    //without a sample of its own the benchmark plays a synthetic one, so results stay comparable between machines
+    juce::TemporaryFile syntheticHit(".wav");
+    auto sampleSource = mSettings.sampleSource;
+
+    if (sampleSource == juce::File())
+    {
+        if (! writeSyntheticHit(syntheticHit.getFile()))
+            return false;
+
+        sampleSource = syntheticHit.getFile();
+    }
+
+    juce::Array<juce::var> results;
+
+    for (auto& density : densities)
+    {
+        for (auto sampleRate : sampleRates)
+        {
+            for (auto numChannels : channelCounts)
+            {
+                juce::AudioBuffer<float> signal(numChannels, static_cast<int>(sampleRate * mSettings.secondsPerRun));
+                fillTestSignal(signal, sampleRate, density.hitsPerSecond);
+
+                for (auto blockSize : blockSizes)
+                {
+                    auto result = runOne(sampleSource, signal, sampleRate, blockSize, density);
+
+                    if (result.isVoid())
+                        return false;
+
+                    std::cout << density.name << ", " << sampleRate << " Hz, " << numChannels << " ch, block " << blockSize << ": "
+                              << static_cast<double>(result["nsPerSample"]) << " ns/sample, worst block "
+                              << static_cast<double>(result["worstBlockMicroseconds"]) << " us" << std::endl;
+
+                    results.add(result);
+                }
+            }
+        }
+    }
+
+    juce::DynamicObject::Ptr root(new juce::DynamicObject());
+    root->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty("secondsPerRun", mSettings.secondsPerRun);
+    root->setProperty("sample", mSettings.sampleSource == juce::File() ? juce::String("synthetic") : mSettings.sampleSource.getFullPathName());
+    root->setProperty("results", results);
+
+    return outputFile.replaceWithText(juce::JSON::toString(juce::var(root.get())));
+}
+
+juce::var ProcessorBenchmark::runOne(const juce::File& sampleSource, const juce::AudioBuffer<float>& signal, double sampleRate, int blockSize, const Density& density)
+{
+    auto numChannels = signal.getNumChannels();
+    auto numSamples = signal.getNumSamples();
+
+    AnyDrum001AudioProcessor processor;
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+    layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+
+    if (! processor.setBusesLayout(layout))
+        return {};
+
+    //settings the test signal actually triggers at, with midi on so the hits can be counted
+    processor.setParameterFromText("toggle", "1");
+    processor.setParameterFromText("threshold", "0.5");
+    processor.setParameterFromText("mask", "1000");
+    processor.setParameterFromText("outputmode", "Audio + MIDI");
+
+    for (auto& parameterID : mSettings.parameterValues.getAllKeys())
+        if (! processor.setParameterFromText(parameterID, mSettings.parameterValues[parameterID]))
+            return {};
+
+    processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    processor.currentlyLoadedFile = sampleSource;
+
+    if (! processor.loadSampleFileNow())
+        return {};
+
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::MidiBuffer midiMessages;
+
+    auto processSignal = [&](int startSample, int endSample, bool isTimed, juce::int64& totalTicks, juce::int64& worstTicks, int& numHits)
+    {
+        for (int start = startSample; start < endSample; start += blockSize)
+        {
+            auto numThisBlock = juce::jmin(blockSize, endSample - start);
+
+            buffer.setSize(numChannels, numThisBlock, false, false, true);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                buffer.copyFrom(channel, 0, signal, channel, start, numThisBlock);
+
+            midiMessages.clear();
+
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            processor.processBlock(buffer, midiMessages);
+            auto ticks = juce::Time::getHighResolutionTicks() - startTicks;
+
+            if (! isTimed)
+                continue;
+
+            totalTicks += ticks;
+            worstTicks = juce::jmax(worstTicks, ticks);
+
+            for (const auto metadata : midiMessages)
+                if (metadata.getMessage().isNoteOn())
+                    ++numHits;
+        }
+    };
+
+    //a short untimed pass first, so caches and branch predictors are warm before anything is measured
+    juce::int64 totalTicks = 0;
+    juce::int64 worstTicks = 0;
+    int numHits = 0;
+
+    processSignal(0, juce::jmin(numSamples, static_cast<int>(sampleRate * 0.25)), false, totalTicks, worstTicks, numHits);
+    processSignal(0, numSamples, true, totalTicks, worstTicks, numHits);
+
+    processor.releaseResources();
+
+    auto totalSeconds = juce::Time::highResolutionTicksToSeconds(totalTicks);
+    auto worstSeconds = juce::Time::highResolutionTicksToSeconds(worstTicks);
+    auto numBlocks = (numSamples + blockSize - 1) / blockSize;
+    auto deadlineSeconds = blockSize / sampleRate;
+
+    juce::DynamicObject::Ptr result(new juce::DynamicObject());
+    result->setProperty("density", juce::String(density.name));
+    result->setProperty("sampleRate", sampleRate);
+    result->setProperty("channels", numChannels);
+    result->setProperty("blockSize", blockSize);
+    result->setProperty("hits", numHits);
+    result->setProperty("nsPerSample", totalSeconds * 1.0e9 / juce::jmax(1, numSamples));
+    result->setProperty("meanBlockMicroseconds", totalSeconds * 1.0e6 / juce::jmax(1, numBlocks));
+    result->setProperty("worstBlockMicroseconds", worstSeconds * 1.0e6);
+    result->setProperty("worstBlockDeadlineRatio", worstSeconds / deadlineSeconds);//above 1 would be a dropout
+
+    return juce::var(result.get());
+}
+
+//==============================================================================
+void ProcessorBenchmark::fillTestSignal(juce::AudioBuffer<float>& signal, double sampleRate, double hitsPerSecond)
+{
+    juce::Random random(1234);//fixed seed, so every run sees the same signal
+
+    auto numSamples = signal.getNumSamples();
+    auto hitSpacing = hitsPerSecond > 0.0 ? sampleRate / hitsPerSecond : 0.0;
+    auto decay = std::exp(-1.0 / (0.03 * sampleRate));//30ms time constant
+
+    for (int channel = 0; channel < signal.getNumChannels(); ++channel)
+    {
+        auto* samples = signal.getWritePointer(channel);
+        auto envelope = 0.0;
+        auto nextHit = hitSpacing > 0.0 ? 0.0 : static_cast<double>(numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            if (i >= nextHit)
+            {
+                envelope = 0.9;
+                nextHit += hitSpacing;
+            }
+
+            //a faint noise floor under the bursts, so silence isn't all zeros
+            auto noise = random.nextFloat() * 2.0f - 1.0f;
+            samples[i] = static_cast<float>(noise * (envelope + 0.001));
+            envelope *= decay;
+        }
+    }
+}
+
+bool ProcessorBenchmark::writeSyntheticHit(const juce::File& file)
+{
+    auto sampleRate = 44100.0;
+    juce::AudioBuffer<float> hit(1, static_cast<int>(sampleRate * 0.5));
+
+    //a pitched-down sine with a fast decay, roughly a kick
+    auto phase = 0.0;
+
+    for (int i = 0; i < hit.getNumSamples(); ++i)
+    {
+        auto time = i / sampleRate;
+        auto frequency = 50.0 + 100.0 * std::exp(-time * 30.0);
+
+        phase += juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        hit.setSample(0, i, static_cast<float>(0.8 * std::sin(phase) * std::exp(-time * 8.0)));
+    }
+
+    std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+
+    if (stream == nullptr)
+        return false;
+
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(stream.get(), sampleRate, 1, 24, {}, 0));
+
+    if (writer == nullptr)
+        return false;
+
+    stream.release();//the writer owns it now
+
+    return writer->writeFromAudioSampleBuffer(hit, 0, hit.getNumSamples());
+}
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    ProcessorBenchmark.h
+
+    Runs AnyDrum001AudioProcessor headless over a sweep of block sizes,
+    sample rates, channel counts and trigger densities, timing every
+    processBlock() call, and writes the results out as json so releases
+    can be compared against each other.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class ProcessorBenchmark
+{
+public:
+    //==============================================================================
+    struct Settings
+    {
+        juce::File sampleSource;//a synthetic hit is used when this is left empty
+        double secondsPerRun = 4.0;
+        juce::StringPairArray parameterValues;//applied on top of the benchmark's own settings
+    };
+
+    explicit ProcessorBenchmark(const Settings& settings);
+
+    //runs every combination and writes the results to outputFile. returns false if nothing could run.
+    bool run(const juce::File& outputFile);
+
+    //==============================================================================
+    //hits generated at 120 bpm, from none at all up to 32nd-note rolls
+    struct Density
+    {
+        const char* name;
+        double hitsPerSecond;
+    };
+
+    //fills the buffer with deterministic decaying noise bursts, starting one every 1 / hitsPerSecond seconds
+    static void fillTestSignal(juce::AudioBuffer<float>& signal, double sampleRate, double hitsPerSecond);
+
+private:
+    //==============================================================================
+    juce::var runOne(const juce::File& sampleSource, const juce::AudioBuffer<float>& signal, double sampleRate, int blockSize, const Density& density);
+    static bool writeSyntheticHit(const juce::File& file);
+
+    Settings mSettings;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProcessorBenchmark)
+};
@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+    ProcessorTelemetry.cpp
+
+  ==============================================================================
+*/
+
+#include "ProcessorTelemetry.h"
+
+namespace
+{
+    //the audio thread is the only writer, so a relaxed load and store is all an increment needs
+    void increment(std::atomic<juce::uint64>& counter, juce::uint64 amount = 1) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+}
+
+//==============================================================================
+void ProcessorTelemetry::recordBlock(juce::int64 startTicks, int numSamples, double sampleRate) noexcept
+{
+    if (mResetRequested.exchange(false))
+        reset();
+
+    if (numSamples <= 0 || sampleRate <= 0.0)
+        return;
+
+    auto duration = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    auto load = duration * sampleRate / numSamples;
+
+    increment(mNumBlocks);
+
+    if (load > 1.0)
+        increment(mNumOverruns);
+
+    if (load > mWorstLoad.load(std::memory_order_relaxed))
+        mWorstLoad.store(load, std::memory_order_relaxed);
+
+    auto bucket = juce::jmin(numLoadBuckets - 1, static_cast<int>(load / loadBucketWidth));
+    increment(mLoadHistogram[static_cast<size_t>(bucket)]);
+}
+
+void ProcessorTelemetry::addTriggers(int numFired, int numMasked) noexcept
+{
+    if (numFired > 0)
+        increment(mNumTriggersFired, static_cast<juce::uint64>(numFired));
+
+    if (numMasked > 0)
+        increment(mNumTriggersMasked, static_cast<juce::uint64>(numMasked));
+}
+
+void ProcessorTelemetry::addNotesOutOfRange(int numNotes) noexcept
+{
+    if (numNotes > 0)
+        increment(mNumNotesOutOfRange, static_cast<juce::uint64>(numNotes));
+}
+
+void ProcessorTelemetry::addInputPeak(float peak) noexcept
+{
+    if (peak > mPeakInput.load(std::memory_order_relaxed))
+        mPeakInput.store(peak, std::memory_order_relaxed);
+}
+
+void ProcessorTelemetry::reset() noexcept
+{
+    mNumBlocks.store(0, std::memory_order_relaxed);
+    mNumOverruns.store(0, std::memory_order_relaxed);
+    mNumTriggersFired.store(0, std::memory_order_relaxed);
+    mNumTriggersMasked.store(0, std::memory_order_relaxed);
+    mNumNotesOutOfRange.store(0, std::memory_order_relaxed);
+    mPeakInput.store(0.0f, std::memory_order_relaxed);
+    mWorstLoad.store(0.0, std::memory_order_relaxed);
+
+    for (auto& bucket : mLoadHistogram)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+//==============================================================================
+ProcessorTelemetry::Snapshot ProcessorTelemetry::getSnapshot() const noexcept
+{
+    //the fields can be a block apart from each other, which is fine for a readout
+    Snapshot snapshot;
+
+    snapshot.numBlocks = mNumBlocks.load(std::memory_order_relaxed);
+    snapshot.numOverruns = mNumOverruns.load(std::memory_order_relaxed);
+    snapshot.numTriggersFired = mNumTriggersFired.load(std::memory_order_relaxed);
+    snapshot.numTriggersMasked = mNumTriggersMasked.load(std::memory_order_relaxed);
+    snapshot.numNotesOutOfRange = mNumNotesOutOfRange.load(std::memory_order_relaxed);
+    snapshot.peakInput = mPeakInput.load(std::memory_order_relaxed);
+    snapshot.worstLoad = mWorstLoad.load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < mLoadHistogram.size(); ++i)
+        snapshot.loadHistogram[i] = mLoadHistogram[i].load(std::memory_order_relaxed);
+
+    return snapshot;
+}
+
+bool ProcessorTelemetry::dumpToFile(const juce::File& file) const
+{
+    auto snapshot = getSnapshot();
+    auto text = "AnyDrum diagnostics, " + juce::Time::getCurrentTime().toString(true, true) + "\n\n" + snapshot.toText() + "\n\nblock load histogram (% of deadline: blocks)\n";
+
+    for (int i = 0; i < numLoadBuckets; ++i)
+    {
+        auto count = snapshot.loadHistogram[static_cast<size_t>(i)];
+
+        if (count > 0)
+            text << juce::roundToInt(i * loadBucketWidth * 100.0) << (i == numLoadBuckets - 1 ? "+" : "") << "%: " << juce::String(count) << "\n";
+    }
+
+    return file.replaceWithText(text);
+}
+
+//==============================================================================
+double ProcessorTelemetry::Snapshot::getLoadPercentile(double percentile) const noexcept
+{
+    juce::uint64 total = 0;
+
+    for (auto count : loadHistogram)
+        total += count;
+
+    if (total == 0)
+        return 0.0;
+
+    auto target = static_cast<juce::uint64>(std::ceil(percentile * static_cast<double>(total)));
+    juce::uint64 runningTotal = 0;
+
+    for (int i = 0; i < numLoadBuckets; ++i)
+    {
+        runningTotal += loadHistogram[static_cast<size_t>(i)];
+
+        //the top edge of the bucket, or the worst block seen if it's the open-ended last one
+        if (runningTotal >= target)
+            return i == numLoadBuckets - 1 ? worstLoad : juce::jmin(worstLoad, (i + 1) * loadBucketWidth);
+    }
+
+    return worstLoad;
+}
+
+juce::String ProcessorTelemetry::Snapshot::toText() const
+{
+    auto percent = [](double load) { return juce::String(load * 100.0, 1) + "%"; };
+
+    juce::String text;
+
+    text << "blocks: " << juce::String(numBlocks) << "\n"
+         << "blocks over deadline: " << juce::String(numOverruns) << "\n"
+         << "block load p50 / p90 / p99 / p99.9: " << percent(getLoadPercentile(0.5)) << " / " << percent(getLoadPercentile(0.9))
+         << " / " << percent(getLoadPercentile(0.99)) << " / " << percent(getLoadPercentile(0.999)) << "\n"
+         << "worst block: " << percent(worstLoad) << " of its deadline\n"
+         << "triggers fired: " << juce::String(numTriggersFired) << "\n"
+         << "triggers masked: " << juce::String(numTriggersMasked) << "\n"
+         << "midi notes out of range: " << juce::String(numNotesOutOfRange) << "\n"
+         << "peak input: " << juce::String(juce::Decibels::gainToDecibels(peakInput), 1) << " dBFS";
+
+    return text;
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    ProcessorTelemetry.h
+
+    Cheap running statistics recorded by the audio thread: how long each
+    block took against its deadline, how many hits fired or were masked,
+    how many midi notes fell outside 0-127, and the loudest input seen. Everything is a relaxed atomic with the
+    audio thread as its only writer, so the editor can read it at any time
+    without blocking anything.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class ProcessorTelemetry
+{
+public:
+    //==============================================================================
+    static constexpr int numLoadBuckets = 100;//2% of the deadline each, the last one catching everything above
+    static constexpr double loadBucketWidth = 0.02;
+
+    struct Snapshot
+    {
+        juce::uint64 numBlocks = 0;
+        juce::uint64 numOverruns = 0;//blocks that took longer to process than the audio they hold
+        juce::uint64 numTriggersFired = 0;
+        juce::uint64 numTriggersMasked = 0;
+        juce::uint64 numNotesOutOfRange = 0;//per-channel hits whose midi note would have been above 127
+        float peakInput = 0.0f;
+        double worstLoad = 0.0;
+        std::array<juce::uint64, numLoadBuckets> loadHistogram{};
+
+        //the block load, as a fraction of the deadline, that the given share of blocks came in under
+        double getLoadPercentile(double percentile) const noexcept;
+
+        juce::String toText() const;
+    };
+
+    //==============================================================================
+    //audio thread only
+    void recordBlock(juce::int64 startTicks, int numSamples, double sampleRate) noexcept;
+    void addTriggers(int numFired, int numMasked) noexcept;
+    void addNotesOutOfRange(int numNotes) noexcept;
+    void addInputPeak(float peak) noexcept;
+
+    //==============================================================================
+    //safe from any thread, and never waits on the audio thread
+    Snapshot getSnapshot() const noexcept;
+
+    //the audio thread clears everything at the end of its next block
+    void requestReset() noexcept                { mResetRequested = true; }
+
+    bool dumpToFile(const juce::File& file) const;
+
+private:
+    //==============================================================================
+    void reset() noexcept;
+
+    std::atomic<juce::uint64> mNumBlocks{ 0 };
+    std::atomic<juce::uint64> mNumOverruns{ 0 };
+    std::atomic<juce::uint64> mNumTriggersFired{ 0 };
+    std::atomic<juce::uint64> mNumTriggersMasked{ 0 };
+    std::atomic<juce::uint64> mNumNotesOutOfRange{ 0 };
+    std::atomic<float> mPeakInput{ 0.0f };
+    std::atomic<double> mWorstLoad{ 0.0 };
+    std::array<std::atomic<juce::uint64>, numLoadBuckets> mLoadHistogram{};
+
+    std::atomic<bool> mResetRequested{ false };
+};
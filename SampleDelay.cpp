@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    SampleDelay.cpp
+
+  ==============================================================================
+*/
+
+#include "SampleDelay.h"
+
+//==============================================================================
+void SampleDelay::prepare(int numChannels, int maximumDelayInSamples, int maximumBlockSize)
+{
+    mMaximumDelay = juce::jmax(0, maximumDelayInSamples);
+    mMaximumBlockSize = juce::jmax(1, maximumBlockSize);
+
+    //room for the longest delay plus one block, so a block can be written before it's read back
+    mDelayBuffer.setSize(juce::jmax(1, numChannels), mMaximumDelay + mMaximumBlockSize);
+    reset();
+}
+
+void SampleDelay::reset() noexcept
+{
+    mDelayBuffer.clear();
+    mWritePosition = 0;
+}
+
+void SampleDelay::process(juce::AudioBuffer<float>& buffer, int numSamples, int delayInSamples) noexcept
+{
+    auto delay = juce::jlimit(0, mMaximumDelay, delayInSamples);
+
+    //hosts occasionally send bigger blocks than they announced, so work in chunks that fit
+    for (int start = 0; start < numSamples; start += mMaximumBlockSize)
+        processChunk(buffer, start, juce::jmin(mMaximumBlockSize, numSamples - start), delay);
+}
+
+void SampleDelay::processChunk(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, int delayInSamples) noexcept
+{
+    auto size = mDelayBuffer.getNumSamples();
+    auto numChannels = juce::jmin(buffer.getNumChannels(), mDelayBuffer.getNumChannels());
+
+    auto readPosition = mWritePosition - delayInSamples;
+
+    if (readPosition < 0)
+        readPosition += size;
+
+    auto numBeforeWrap = juce::jmin(numSamples, size - mWritePosition);
+    auto numBeforeReadWrap = juce::jmin(numSamples, size - readPosition);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* data = buffer.getWritePointer(channel, startSample);
+        auto* ring = mDelayBuffer.getWritePointer(channel);
+
+        juce::FloatVectorOperations::copy(ring + mWritePosition, data, numBeforeWrap);
+        juce::FloatVectorOperations::copy(ring, data + numBeforeWrap, numSamples - numBeforeWrap);
+
+        juce::FloatVectorOperations::copy(data, ring + readPosition, numBeforeReadWrap);
+        juce::FloatVectorOperations::copy(data + numBeforeReadWrap, ring, numSamples - numBeforeReadWrap);
+    }
+
+    mWritePosition = (mWritePosition + numSamples) % size;
+}
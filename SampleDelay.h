@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+    SampleDelay.h
+
+    A multichannel delay line with a variable delay, used to hold the signal
+    path back by the detector's latency. All memory is allocated in prepare().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class SampleDelay
+{
+public:
+    //==============================================================================
+    //allocates the delay memory. call from prepareToPlay(), never from the audio thread.
+    void prepare(int numChannels, int maximumDelayInSamples, int maximumBlockSize);
+    void reset() noexcept;
+
+    //delays the first numSamples of every channel in place
+    void process(juce::AudioBuffer<float>& buffer, int numSamples, int delayInSamples) noexcept;
+
+    int getMaximumDelay() const noexcept    { return mMaximumDelay; }
+
+private:
+    //==============================================================================
+    void processChunk(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, int delayInSamples) noexcept;
+
+    juce::AudioBuffer<float> mDelayBuffer;
+    int mWritePosition = 0;
+    int mMaximumDelay = 0;
+    int mMaximumBlockSize = 0;
+};
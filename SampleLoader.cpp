@@ -0,0 +1,317 @@
+/*
+  ==============================================================================
+
+    SampleLoader.cpp
+
+  ==============================================================================
+*/
+
+#include "SampleLoader.h"
+
+//==============================================================================
+SampleLoader::SampleLoader()
+    : juce::Thread("AnyDrum sample loader")
+{
+    startThread();
+}
+
+SampleLoader::~SampleLoader()
+{
+    stopThread(4000);
+
+    //let go of every kit first, so samples no other instance is using are freed now rather than at their next purge
+    mRetired.clear();
+    mLatest = nullptr;
+    mSamplePool->purge();
+}
+
+//==============================================================================
+void SampleLoader::loadAsync(int slot, const juce::File& source)
+{
+    if (! juce::isPositiveAndBelow(slot, DrumKit::numSlots))
+        return;
+
+    {
+        const juce::ScopedLock sl(mLock);
+        mRequests[static_cast<size_t>(slot)] = { source, nullptr, nullptr };
+    }
+
+    notify();
+}
+
+void SampleLoader::loadEmbeddedAsync(int slot, const juce::XmlElement& layout, std::shared_ptr<const DrumSampleSet::EmbeddedAudio> audio)
+{
+    if (! juce::isPositiveAndBelow(slot, DrumKit::numSlots))
+        return;
+
+    auto embeddedLayout = std::make_shared<const juce::XmlElement>(layout);
+
+    {
+        const juce::ScopedLock sl(mLock);
+        mRequests[static_cast<size_t>(slot)] = { {}, std::move(embeddedLayout), std::move(audio) };
+    }
+
+    notify();
+}
+
+bool SampleLoader::loadNow(int slot, const juce::File& source)
+{
+    if (! juce::isPositiveAndBelow(slot, DrumKit::numSlots))
+        return false;
+
+    double playbackRate;
+    DrumSample::Resampler resampler;
+
+    {
+        const juce::ScopedLock sl(mLock);
+        playbackRate = mPlaybackRate;
+        resampler = mResampler;
+    }
+
+    SlotSets newSets;
+    newSets[static_cast<size_t>(slot)] = DrumSampleSet::loadFrom(*mSamplePool, source, playbackRate, resampler);
+
+    if (newSets[static_cast<size_t>(slot)] == nullptr)
+        return false;
+
+    publish(newSets);
+    return true;
+}
+
+bool SampleLoader::isLoading() const
+{
+    const juce::ScopedLock sl(mLock);
+
+    if (mIsDecoding)
+        return true;
+
+    for (auto& request : mRequests)
+        if (! request.isEmpty())
+            return true;
+
+    return false;
+}
+
+void SampleLoader::setPlaybackFormat(double sampleRate, DrumSample::Resampler resampler)
+{
+    auto hasQueuedReload = false;
+
+    {
+        const juce::ScopedLock sl(mLock);
+
+        if (sampleRate == mPlaybackRate && resampler == mResampler)
+            return;
+
+        mPlaybackRate = sampleRate;
+        mResampler = resampler;
+
+        //requests still waiting will pick up the new format by themselves, and while decoding, run() checks
+        //every slot again once it's published what it was doing
+        if (mIsDecoding)
+            return;
+
+        hasQueuedReload = queueStaleSets();
+    }
+
+    if (hasQueuedReload)
+        notify();
+}
+
+DrumKit::Ptr SampleLoader::getLatestKit() const
+{
+    const juce::ScopedLock sl(mLock);
+    return mLatest;
+}
+
+//==============================================================================
+void SampleLoader::audioThreadFinishedBlock(DrumKit* inUse, DrumKit* retiring) noexcept
+{
+    storeAudioKits(inUse, retiring, 1);
+}
+
+void SampleLoader::audioThreadStopped() noexcept
+{
+    storeAudioKits(nullptr, nullptr, 2);
+
+    notify();
+}
+
+void SampleLoader::storeAudioKits(DrumKit* inUse, DrumKit* retiring, juce::uint32 numEpochs) noexcept
+{
+    //odd while the two pointers are being written, so the loader never pairs one block's in-use kit with another's retiring one
+    mAudioGeneration.fetch_add(1);
+    mAudioInUse.store(inUse);
+    mAudioRetiring.store(retiring);
+    mAudioGeneration.fetch_add(1);
+
+    mAudioEpoch.fetch_add(numEpochs);
+}
+
+SampleLoader::AudioKits SampleLoader::loadAudioKits() const noexcept
+{
+    for (;;)
+    {
+        auto generation = mAudioGeneration.load();
+
+        if ((generation & 1) == 0)
+        {
+            AudioKits kits{ mAudioEpoch.load(), mAudioInUse.load(), mAudioRetiring.load() };
+
+            if (mAudioGeneration.load() == generation)
+                return kits;
+        }
+
+        //the audio thread is between its two stores, which only takes a moment
+        juce::Thread::yield();
+    }
+}
+
+//==============================================================================
+void SampleLoader::run()
+{
+    while (! threadShouldExit())
+    {
+        SlotRequests requests;
+        auto hasRequests = false;
+        double playbackRate = 0.0;
+        auto resampler = DrumSample::Resampler::windowedSinc;
+
+        {
+            const juce::ScopedLock sl(mLock);
+
+            for (size_t slot = 0; slot < requests.size(); ++slot)
+            {
+                requests[slot] = mRequests[slot];
+                mRequests[slot] = {};
+                hasRequests = hasRequests || ! requests[slot].isEmpty();
+            }
+
+            if (hasRequests)
+            {
+                playbackRate = mPlaybackRate;
+                resampler = mResampler;
+                mIsDecoding = true;
+            }
+        }
+
+        if (hasRequests)
+        {
+            //the slow part, done without holding anything the message thread might want
+            SlotSets newSets;
+            auto hasNewSets = false;
+
+            for (size_t slot = 0; slot < requests.size(); ++slot)
+            {
+                if (! requests[slot].isEmpty())
+                {
+                    newSets[slot] = load(requests[slot], playbackRate, resampler);
+                    hasNewSets = hasNewSets || newSets[slot] != nullptr;
+                }
+            }
+
+            //everything decoded in one pass goes out as one kit, so the audio thread only sees one swap
+            if (hasNewSets)
+                publish(newSets);
+
+            const juce::ScopedLock sl(mLock);
+            mIsDecoding = false;
+
+            //the host may have changed format while we were decoding, which setPlaybackFormat() left to us,
+            //so anything made for another one is done again, whichever slot it's in. if it hasn't, a reload
+            //that failed isn't retried: that set keeps playing, converted on the fly, until the format changes.
+            if (mPlaybackRate != playbackRate || mResampler != resampler)
+                queueStaleSets();
+        }
+
+        collectGarbage();
+
+        wait(100);
+    }
+}
+
+bool SampleLoader::queueStaleSets()
+{
+    if (mLatest == nullptr)
+        return false;
+
+    auto hasQueued = false;
+
+    for (int slot = 0; slot < DrumKit::numSlots; ++slot)
+    {
+        auto* set = mLatest->getSet(slot);
+        auto& request = mRequests[static_cast<size_t>(slot)];
+
+        if (set == nullptr || ! request.isEmpty())
+            continue;
+
+        //a set restored from the session is reloaded from the audio the pool archived for it
+        if (set->getPlaybackRate() != mPlaybackRate || set->getResampler() != mResampler)
+        {
+            request = { set->getSource(), set->getEmbeddedLayout(), nullptr };
+            hasQueued = true;
+        }
+    }
+
+    return hasQueued;
+}
+
+DrumSampleSet::Ptr SampleLoader::load(const Request& request, double playbackRate, DrumSample::Resampler resampler)
+{
+    if (request.embeddedLayout != nullptr)
+        return DrumSampleSet::loadFromEmbedded(*mSamplePool, *request.embeddedLayout, request.embeddedAudio.get(), playbackRate, resampler);
+
+    return DrumSampleSet::loadFrom(*mSamplePool, request.source, playbackRate, resampler);
+}
+
+void SampleLoader::publish(const SlotSets& newSets)
+{
+    {
+        const juce::ScopedLock sl(mLock);
+
+        auto newKit = mLatest != nullptr ? mLatest->withSets(newSets) : DrumKit().withSets(newSets);
+
+        mPublished.store(newKit.get());
+
+        //the epoch is read after the swap (both sequentially consistent), so two more finished blocks guarantee the audio thread has picked it up
+        if (mLatest != nullptr)
+            mRetired.push_back({ mLatest, mAudioEpoch.load() });
+
+        mLatest = newKit;
+    }
+
+    sendChangeMessage();
+}
+
+void SampleLoader::collectGarbage()
+{
+    std::vector<DrumKit::Ptr> toFree;
+
+    {
+        const juce::ScopedLock sl(mLock);
+
+        auto audioKits = loadAudioKits();
+
+        for (auto it = mRetired.begin(); it != mRetired.end();)
+        {
+            auto* kit = it->kit.get();
+
+            if (audioKits.epoch - it->epoch >= 2 && kit != audioKits.inUse && kit != audioKits.retiring)
+            {
+                toFree.push_back(it->kit);
+                it = mRetired.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    if (toFree.empty())
+        return;
+
+    //the last references go here, outside the lock. sets still shared with the live kit survive,
+    //and so do samples another instance is still using.
+    toFree.clear();
+    mSamplePool->purge();
+}
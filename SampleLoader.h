@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    SampleLoader.h
+
+    Decodes sample sets on a background thread, converting them to the host
+    rate, and hands them to the audio thread as a kit, with an atomic pointer
+    swap. Kits the audio thread has moved on from are freed back on the
+    loader thread, never on the audio thread. Listeners hear about every new
+    kit on the message thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DrumKit.h"
+
+//==============================================================================
+/**
+    The audio thread calls getKitForAudioThread() at the start of every block
+    and audioThreadFinishedBlock() at the end, saying which kits its voices may
+    still be reading. A replaced kit is only freed once the audio thread has
+    finished two blocks since the swap and reports no longer using it.
+*/
+class SampleLoader  : public juce::ChangeBroadcaster,
+                      private juce::Thread
+{
+public:
+    //==============================================================================
+    SampleLoader();
+    ~SampleLoader() override;
+
+    //==============================================================================
+    //queues a load into one kit slot, replacing any request for that slot that hasn't started yet
+    void loadAsync(int slot, const juce::File& source);
+
+    //queues a set restored from a session, to be decoded from its embedded audio rather than from disk
+    void loadEmbeddedAsync(int slot, const juce::XmlElement& layout, std::shared_ptr<const DrumSampleSet::EmbeddedAudio> audio);
+
+    //decodes on the calling thread and publishes straight away. for offline use.
+    bool loadNow(int slot, const juce::File& source);
+
+    bool isLoading() const;
+
+    //the rate and resampler new sets are converted with. any loaded set made for something else is
+    //reloaded in the background, and keeps playing until then.
+    void setPlaybackFormat(double sampleRate, DrumSample::Resampler resampler);
+
+    //the most recently published kit. message thread only.
+    DrumKit::Ptr getLatestKit() const;
+
+    SamplePool& getSamplePool() noexcept                    { return *mSamplePool; }
+
+    //==============================================================================
+    DrumKit* getKitForAudioThread() const noexcept          { return mPublished.load(); }
+    void audioThreadFinishedBlock(DrumKit* inUse, DrumKit* retiring) noexcept;
+
+    //call when processing stops, so replaced kits can be freed without waiting for more blocks
+    void audioThreadStopped() noexcept;
+
+private:
+    //==============================================================================
+    using SlotSets = std::array<DrumSampleSet::Ptr, DrumKit::numSlots>;
+
+    struct Request
+    {
+        juce::File source;
+        std::shared_ptr<const juce::XmlElement> embeddedLayout;//set when the audio comes from the session
+        std::shared_ptr<const DrumSampleSet::EmbeddedAudio> embeddedAudio;
+
+        bool isEmpty() const noexcept   { return source == juce::File() && embeddedLayout == nullptr; }
+    };
+
+    using SlotRequests = std::array<Request, DrumKit::numSlots>;
+
+    void run() override;
+    bool queueStaleSets();//queues a reload for every published set not made at the current format. call with mLock held.
+    DrumSampleSet::Ptr load(const Request& request, double playbackRate, DrumSample::Resampler resampler);
+    void publish(const SlotSets& newSets);
+    void collectGarbage();
+
+    //what the audio thread said it was using at the end of its last block, always read as one snapshot
+    struct AudioKits
+    {
+        juce::uint32 epoch;
+        DrumKit* inUse;
+        DrumKit* retiring;
+    };
+
+    void storeAudioKits(DrumKit* inUse, DrumKit* retiring, juce::uint32 numEpochs) noexcept;
+    AudioKits loadAudioKits() const noexcept;
+
+    struct RetiredKit
+    {
+        DrumKit::Ptr kit;
+        juce::uint32 epoch;
+    };
+
+    juce::SharedResourcePointer<SamplePool> mSamplePool;//shared with every other instance in the process
+
+    //never taken on the audio thread
+    juce::CriticalSection mLock;
+    SlotRequests mRequests;//empty where there's nothing queued
+    bool mIsDecoding = false;
+    double mPlaybackRate = 0.0;
+    DrumSample::Resampler mResampler = DrumSample::Resampler::windowedSinc;
+    DrumKit::Ptr mLatest;
+    std::vector<RetiredKit> mRetired;
+
+    std::atomic<DrumKit*> mPublished{ nullptr };
+    std::atomic<DrumKit*> mAudioInUse{ nullptr };
+    std::atomic<DrumKit*> mAudioRetiring{ nullptr };
+    std::atomic<juce::uint32> mAudioEpoch{ 0 };
+    std::atomic<juce::uint32> mAudioGeneration{ 0 };//odd while the audio thread is updating the two pointers above
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleLoader)
+};
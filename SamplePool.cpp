@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+
+    SamplePool.cpp
+
+  ==============================================================================
+*/
+
+#include "SamplePool.h"
+
+//==============================================================================
+SamplePool::SamplePool()
+{
+    mFormatManager.registerBasicFormats();
+}
+
+DrumSample::Ptr SamplePool::getSample(const juce::File& file, double playbackRate, DrumSample::Resampler resampler)
+{
+    auto fileKey = makeFileKey(file);
+    auto entry = getEntry(fileKey + "|" + makeFormatKey(playbackRate, resampler), fileKey, {});
+
+    //anyone else after the same file waits here for the first decode rather than doing their own
+    const juce::ScopedLock decoding(entry->decodeLock);
+
+    if (entry->sample == nullptr)
+    {
+        juce::String hash;
+
+        {
+            const juce::ScopedLock sl(mLock);
+            auto it = mFileHashes.find(fileKey);
+
+            if (it != mFileHashes.end())
+                hash = it->second;
+        }
+
+        //the lossless copy is made from this decode, here on the loader thread, the first time the file is
+        //loaded at any format. saving then only has to look it up.
+        juce::MemoryBlock lossless;
+        auto sample = DrumSample::loadFromFile(mFormatManager, file, playbackRate, resampler, hash.isEmpty() ? &lossless : nullptr, hash);
+
+        const juce::ScopedLock sl(mLock);
+
+        if (sample != nullptr && hash.isEmpty() && sample->getContentHash().isNotEmpty())
+        {
+            if (mArchive.find(sample->getContentHash()) == mArchive.end())
+                mArchive[sample->getContentHash()] = std::move(lossless);
+
+            mFileHashes[fileKey] = sample->getContentHash();
+        }
+
+        entry->sample = sample;
+    }
+
+    return entry->sample;
+}
+
+DrumSample::Ptr SamplePool::getEmbeddedSample(const juce::String& hash, const juce::MemoryBlock* data, const juce::File& sourceFile,
+                                              double playbackRate, DrumSample::Resampler resampler)
+{
+    Entry::Ptr entry;
+
+    {
+        //the entry keeps the archived audio from being purged until the decode is done, so it has to exist
+        //before the lock is let go, or another instance's purge could drop the audio in between
+        const juce::ScopedLock sl(mLock);
+
+        entry = getEntry("#" + hash + "|" + makeFormatKey(playbackRate, resampler), {}, hash);
+
+        if (data != nullptr && mArchive.find(hash) == mArchive.end())
+            mArchive[hash] = *data;
+    }
+
+    const juce::ScopedLock decoding(entry->decodeLock);
+
+    if (entry->sample == nullptr)
+    {
+        juce::MemoryBlock archived;
+
+        {
+            const juce::ScopedLock sl(mLock);
+            auto it = mArchive.find(hash);
+
+            if (it != mArchive.end())
+                archived = it->second;
+        }
+
+        if (! archived.isEmpty())
+            entry->sample = DrumSample::loadFromLosslessData(archived, hash, sourceFile, playbackRate, resampler);
+    }
+
+    return entry->sample;
+}
+
+bool SamplePool::getLosslessData(const DrumSample& sample, juce::String& hash, juce::MemoryBlock& data)
+{
+    hash = sample.getContentHash();
+
+    if (hash.isEmpty())
+        return false;
+
+    const juce::ScopedLock sl(mLock);
+    auto it = mArchive.find(hash);
+
+    if (it == mArchive.end())
+        return false;
+
+    data = it->second;
+    return true;
+}
+
+void SamplePool::purge()
+{
+    std::vector<Entry::Ptr> toFree;
+    std::vector<juce::MemoryBlock> archiveToFree;
+
+    {
+        const juce::ScopedLock sl(mLock);
+
+        for (auto it = mEntries.begin(); it != mEntries.end();)
+        {
+            auto& entry = it->second;
+
+            //an entry someone is fetching or decoding has more references than the map's own. entries are only
+            //handed out under mLock, and samples only by whoever holds an entry, so neither count can rise here.
+            auto isUnused = entry->getReferenceCount() == 1
+                             && (entry->sample == nullptr || entry->sample->getReferenceCount() == 1);
+
+            if (isUnused)
+            {
+                toFree.push_back(entry);
+                it = mEntries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        //archived audio is kept for as long as a sample made from it, or from its file, is still around
+        std::set<juce::String> liveFileKeys, liveHashes;
+
+        for (auto& keyAndEntry : mEntries)
+        {
+            auto& entry = keyAndEntry.second;
+
+            if (entry->hash.isNotEmpty())
+                liveHashes.insert(entry->hash);
+            else
+                liveFileKeys.insert(entry->fileKey);
+
+            if (entry->sample != nullptr && entry->sample->getContentHash().isNotEmpty())
+                liveHashes.insert(entry->sample->getContentHash());
+        }
+
+        for (auto it = mFileHashes.begin(); it != mFileHashes.end();)
+        {
+            if (liveFileKeys.count(it->first) > 0)
+            {
+                liveHashes.insert(it->second);
+                ++it;
+            }
+            else
+            {
+                it = mFileHashes.erase(it);
+            }
+        }
+
+        for (auto it = mArchive.begin(); it != mArchive.end();)
+        {
+            if (liveHashes.count(it->first) > 0)
+            {
+                ++it;
+            }
+            else
+            {
+                archiveToFree.push_back(std::move(it->second));
+                it = mArchive.erase(it);
+            }
+        }
+    }
+
+    //the decoded audio is freed here, outside the lock
+    toFree.clear();
+    archiveToFree.clear();
+}
+
+SamplePool::Entry::Ptr SamplePool::getEntry(const juce::String& key, const juce::String& fileKey, const juce::String& hash)
+{
+    const juce::ScopedLock sl(mLock);
+
+    auto& slot = mEntries[key];
+
+    if (slot == nullptr)
+    {
+        slot = new Entry();
+        slot->fileKey = fileKey;
+        slot->hash = hash;
+    }
+
+    return slot;
+}
+
+juce::String SamplePool::makeFileKey(const juce::File& file)
+{
+    return file.getFullPathName() + "|" + juce::String(file.getSize()) + "|" + juce::String(file.getLastModificationTime().toMilliseconds());
+}
+
+juce::String SamplePool::makeFormatKey(double playbackRate, DrumSample::Resampler resampler)
+{
+    return juce::String(playbackRate) + "|" + juce::String(static_cast<int>(resampler));
+}
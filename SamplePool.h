@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    SamplePool.h
+
+    One cache of decoded samples for the whole process, shared by every
+    plugin instance through a SharedResourcePointer. Instances that load the
+    same file at the same rate get the same read-only DrumSample, decoded
+    once, and it's freed when the last set using it goes. The pool also keeps
+    the lossless copies of samples that are embedded in saved sessions.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DrumSample.h"
+
+//==============================================================================
+/**
+    Entries are keyed by path, size and modification time, so a file that's
+    been edited on disk is decoded afresh, and by the rate and resampler it
+    was converted with. Each entry has its own decode lock, so loading
+    different files never waits on one another, and two instances asking for
+    the same file at once only decode it once.
+*/
+class SamplePool
+{
+public:
+    //==============================================================================
+    SamplePool();
+
+    //returns the shared sample, decoding it first if nobody has it yet. nullptr if the file can't be read.
+    //blocks while decoding, so call it from a loader thread, never the audio thread.
+    DrumSample::Ptr getSample(const juce::File& file, double playbackRate, DrumSample::Resampler resampler);
+
+    //the same for audio restored from a session, keyed by content hash, so every instance that embedded
+    //the same sample shares one decoded copy. data may be null if the hash has been archived before.
+    DrumSample::Ptr getEmbeddedSample(const juce::String& hash, const juce::MemoryBlock* data, const juce::File& sourceFile,
+                                      double playbackRate, DrumSample::Resampler resampler);
+
+    //the lossless audio to embed for a sample, encoded from the same decode when the file was first loaded
+    //and archived while the sample's in use. returns false if the sample has none.
+    bool getLosslessData(const DrumSample& sample, juce::String& hash, juce::MemoryBlock& data);
+
+    //forgets every sample nothing outside the pool still uses, freeing its memory and its archived audio
+    void purge();
+
+private:
+    //==============================================================================
+    struct Entry  : public juce::ReferenceCountedObject
+    {
+        using Ptr = juce::ReferenceCountedObjectPtr<Entry>;
+
+        juce::CriticalSection decodeLock;
+        DrumSample::Ptr sample;
+
+        juce::String fileKey;//for samples decoded from a file
+        juce::String hash;//for samples restored from a session
+    };
+
+    //takes mLock, which is re-entrant, so callers may already hold it
+    Entry::Ptr getEntry(const juce::String& key, const juce::String& fileKey, const juce::String& hash);
+
+    static juce::String makeFileKey(const juce::File& file);
+    static juce::String makeFormatKey(double playbackRate, DrumSample::Resampler resampler);
+
+    juce::AudioFormatManager mFormatManager;
+
+    juce::CriticalSection mLock;
+    std::map<juce::String, Entry::Ptr> mEntries;
+    std::map<juce::String, juce::MemoryBlock> mArchive;//lossless audio by content hash
+    std::map<juce::String, juce::String> mFileHashes;//content hash by file key, so other formats of a file aren't encoded again
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SamplePool)
+};
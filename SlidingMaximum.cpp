@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    SlidingMaximum.cpp
+
+  ==============================================================================
+*/
+
+#include "SlidingMaximum.h"
+
+//==============================================================================
+void SlidingMaximum::prepare(int maximumLength)
+{
+    mValues.assign(static_cast<size_t>(juce::jmax(1, maximumLength)), 0.0f);
+    mPositions.assign(mValues.size(), 0);
+
+    reset();
+}
+
+void SlidingMaximum::reset() noexcept
+{
+    mHead = 0;
+    mSize = 0;
+    mPosition = 0;
+}
+
+float SlidingMaximum::push(float value, int windowLength) noexcept
+{
+    auto length = static_cast<juce::uint32>(juce::jlimit(1, getMaximumLength(), windowLength));
+    ++mPosition;
+
+    //drop whatever has slid out of the window...
+    while (mSize > 0 && mPosition - mPositions[static_cast<size_t>(mHead)] >= length)
+    {
+        mHead = wrap(mHead + 1);
+        --mSize;
+    }
+
+    //...and whatever the new value outranks for as long as either is in it
+    while (mSize > 0 && mValues[static_cast<size_t>(wrap(mHead + mSize - 1))] <= value)
+        --mSize;
+
+    auto tail = static_cast<size_t>(wrap(mHead + mSize));
+    mValues[tail] = value;
+    mPositions[tail] = mPosition;
+    ++mSize;
+
+    return mValues[static_cast<size_t>(mHead)];
+}
+
+void SlidingMaximum::seed(const float* values, int numValues, int windowLength) noexcept
+{
+    reset();
+
+    auto numToKeep = juce::jmin(numValues, juce::jlimit(1, getMaximumLength(), windowLength));
+
+    for (int i = numValues - numToKeep; i < numValues; ++i)
+        push(values[i], windowLength);
+}
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    SlidingMaximum.h
+
+    The largest of the last n values pushed, updated on every push in
+    amortised constant time: a monotonic deque that only keeps values which
+    could still become the maximum. All memory is allocated in prepare().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class SlidingMaximum
+{
+public:
+    //==============================================================================
+    //allocates room for the longest window. call from prepareToPlay(), never from the audio thread.
+    void prepare(int maximumLength);
+    void reset() noexcept;
+
+    //adds a value and returns the maximum of the last windowLength values, this one included.
+    //the length may change between calls; a longer window only looks back as far as values were kept.
+    float push(float value, int windowLength) noexcept;
+
+    //starts over from the last windowLength of these values, dropping everything pushed before them
+    void seed(const float* values, int numValues, int windowLength) noexcept;
+
+    //the maximum returned by the last push, or 0 if nothing's been pushed since the last reset
+    float getMaximum() const noexcept       { return mSize > 0 ? mValues[static_cast<size_t>(mHead)] : 0.0f; }
+
+    int getMaximumLength() const noexcept   { return static_cast<int>(mValues.size()); }
+
+private:
+    //==============================================================================
+    int wrap(int index) const noexcept      { return index >= getMaximumLength() ? index - getMaximumLength() : index; }
+
+    //a ring buffer of decreasing values, oldest at mHead, with the position each one was pushed at
+    std::vector<float> mValues;
+    std::vector<juce::uint32> mPositions;
+    int mHead = 0;
+    int mSize = 0;
+    juce::uint32 mPosition = 0;//wraps, which is fine since only differences are used
+};
@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    SpectralFluxDetector.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectralFluxDetector.h"
+
+//==============================================================================
+void SpectralFluxDetector::prepare()
+{
+    mInputRing.assign(static_cast<size_t>(fftSize), 0.0f);
+    mFrame.assign(static_cast<size_t>(fftSize * 2), 0.0f);//the frequency-only transform works in place on 2 * fftSize floats
+    mPreviousMagnitudes.assign(static_cast<size_t>(fftSize / 2 + 1), 0.0f);
+    mFluxHistory.assign(static_cast<size_t>(historyLength), 0.0f);
+
+    mWindow.assign(static_cast<size_t>(fftSize), 0.0f);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(mWindow.data(), static_cast<size_t>(fftSize),
+                                                             juce::dsp::WindowingFunction<float>::hann, false);
+
+    reset();
+}
+
+void SpectralFluxDetector::reset() noexcept
+{
+    std::fill(mInputRing.begin(), mInputRing.end(), 0.0f);
+    std::fill(mPreviousMagnitudes.begin(), mPreviousMagnitudes.end(), 0.0f);
+    std::fill(mFluxHistory.begin(), mFluxHistory.end(), 0.0f);
+
+    mWritePosition = 0;
+    mHopCounter = 0;
+    mHistoryPosition = 0;
+    mSamplesSinceOnset = std::numeric_limits<int>::max() / 2;
+
+    mHopPeak = 0.0f;
+    mAmplitude = 0.0f;
+    mHasOnset = false;
+    mWasMasked = false;
+    mOnsetLevel = 0.0f;
+}
+
+int SpectralFluxDetector::pushSamples(const float* input, int numSamples, float sensitivity, int maskLength) noexcept
+{
+    mHasOnset = false;
+    mWasMasked = false;
+
+    if (mInputRing.empty())
+        return numSamples;
+
+    auto numToPush = juce::jmin(numSamples, hopSize - mHopCounter);
+
+    //copy into the ring in at most two pieces
+    auto numBeforeWrap = juce::jmin(numToPush, fftSize - mWritePosition);
+    juce::FloatVectorOperations::copy(mInputRing.data() + mWritePosition, input, numBeforeWrap);
+    juce::FloatVectorOperations::copy(mInputRing.data(), input + numBeforeWrap, numToPush - numBeforeWrap);
+
+    auto range = juce::FloatVectorOperations::findMinAndMax(input, numToPush);
+    mHopPeak = juce::jmax(mHopPeak, -range.getStart(), range.getEnd());
+
+    mWritePosition = (mWritePosition + numToPush) % fftSize;
+    mHopCounter += numToPush;
+
+    if (mSamplesSinceOnset < maskLength)
+        mSamplesSinceOnset += numToPush;
+
+    if (mHopCounter == hopSize)
+    {
+        analyseFrame(sensitivity, maskLength);
+
+        mAmplitude = mHopPeak;
+        mHopPeak = 0.0f;
+        mHopCounter = 0;
+    }
+
+    return numToPush;
+}
+
+//==============================================================================
+void SpectralFluxDetector::analyseFrame(float sensitivity, int maskLength) noexcept
+{
+    auto startTicks = juce::Time::getHighResolutionTicks();
+
+    //unroll the ring so the oldest sample comes first, windowing as we go
+    auto numBeforeWrap = fftSize - mWritePosition;
+    juce::FloatVectorOperations::multiply(mFrame.data(), mInputRing.data() + mWritePosition, mWindow.data(), numBeforeWrap);
+    juce::FloatVectorOperations::multiply(mFrame.data() + numBeforeWrap, mInputRing.data(), mWindow.data() + numBeforeWrap, mWritePosition);
+    juce::FloatVectorOperations::clear(mFrame.data() + fftSize, fftSize);
+
+    mFFT.performFrequencyOnlyForwardTransform(mFrame.data());
+
+    //a full-scale sine comes out of a hann-windowed transform at about fftSize / 4
+    const auto magnitudeScale = 4.0f / static_cast<float>(fftSize);
+    const auto compression = 10.0f;
+    const auto compressionNormaliser = 1.0f / std::log1p(compression);
+
+    auto numBins = fftSize / 2 + 1;
+    auto flux = 0.0f;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        auto magnitude = std::log1p(compression * mFrame[static_cast<size_t>(bin)] * magnitudeScale) * compressionNormaliser;
+        auto& previous = mPreviousMagnitudes[static_cast<size_t>(bin)];
+
+        flux += juce::jmax(0.0f, magnitude - previous);//only rising energy counts
+        previous = magnitude;
+    }
+
+    flux /= static_cast<float>(numBins);
+
+    //adaptive threshold: the flux has to clear its own recent average by a margin set by the threshold knob
+    auto average = 0.0f;
+
+    for (auto value : mFluxHistory)
+        average += value;
+
+    average /= static_cast<float>(historyLength);
+
+    auto margin = 0.002f + 0.1f * sensitivity * sensitivity;
+
+    if (flux > average * 1.5f + margin)
+    {
+        if (mSamplesSinceOnset >= maskLength)
+        {
+            mHasOnset = true;
+            mOnsetLevel = mHopPeak;
+            mSamplesSinceOnset = 0;
+        }
+        else
+        {
+            mWasMasked = true;
+        }
+    }
+
+    mFluxHistory[static_cast<size_t>(mHistoryPosition)] = flux;
+    mHistoryPosition = (mHistoryPosition + 1) % historyLength;
+
+    auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1.0e6;
+    mAverageFrameMicroseconds += 0.05 * (elapsed - mAverageFrameMicroseconds);
+}
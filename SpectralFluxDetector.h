@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    SpectralFluxDetector.h
+
+    FFT-based onset detection: a hit is reported when the rise in the
+    log-magnitude spectrum from one frame to the next jumps above its own
+    recent average. Picks up soft ghost notes that never reach the peak
+    threshold, and ignores steady bleed that does.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class SpectralFluxDetector
+{
+public:
+    //==============================================================================
+    static constexpr int fftOrder = 9;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = 128;
+    static constexpr int historyLength = 16;//frames in the adaptive threshold's running average
+
+    //an onset can't be seen until it has reached the middle of the analysis window
+    static constexpr int latencySamples = fftSize / 2 + hopSize;
+
+    //==============================================================================
+    //allocates every buffer. call from prepareToPlay(), never from the audio thread.
+    void prepare();
+    void reset() noexcept;
+
+    //consumes samples up to the next hop boundary, analysing a frame if it gets there.
+    //returns the number of samples consumed; check hasOnset() afterwards.
+    int pushSamples(const float* input, int numSamples, float sensitivity, int maskLength) noexcept;
+
+    bool hasOnset() const noexcept                  { return mHasOnset; }
+    float getOnsetLevel() const noexcept            { return mOnsetLevel; }
+
+    //true if the last frame analysed would have been an onset but fell inside the mask
+    bool wasMasked() const noexcept                 { return mWasMasked; }
+
+    //loudest sample in the last complete hop, for metering
+    float getAmplitude() const noexcept             { return mAmplitude; }
+
+    //running average of the time taken to analyse one frame
+    double getAverageFrameMicroseconds() const noexcept     { return mAverageFrameMicroseconds; }
+
+private:
+    //==============================================================================
+    void analyseFrame(float sensitivity, int maskLength) noexcept;
+
+    juce::dsp::FFT mFFT{ fftOrder };
+
+    std::vector<float> mInputRing;
+    std::vector<float> mWindow;
+    std::vector<float> mFrame;
+    std::vector<float> mPreviousMagnitudes;
+    std::vector<float> mFluxHistory;
+
+    int mWritePosition = 0;
+    int mHopCounter = 0;
+    int mHistoryPosition = 0;
+    int mSamplesSinceOnset = 0;
+
+    float mHopPeak = 0.0f;
+    float mAmplitude = 0.0f;
+
+    bool mHasOnset = false;
+    bool mWasMasked = false;
+    float mOnsetLevel = 0.0f;
+
+    double mAverageFrameMicroseconds = 0.0;
+};
@@ -0,0 +1,321 @@
+/*
+  ==============================================================================
+
+    TransientDetector.cpp
+
+  ==============================================================================
+*/
+
+#include "TransientDetector.h"
+
+//==============================================================================
+void DetectorStates::reset() noexcept
+{
+    *this = DetectorStates();
+}
+
+bool DetectorStates::processSample(int i, float level, float windowMaximum, const DetectorSettings& settings) noexcept
+{
+    auto index = static_cast<size_t>(i);
+    auto hasFired = false;
+
+    //the amplitude includes this frame, so the threshold is crossed on the frame the signal crosses it
+    amplitude[index] = windowMaximum;
+
+    //triggering according to sensitivity variables
+    if (settings.threshold < amplitude[index])
+    {
+        if (level > offsetPeak[index])
+            offsetPeak[index] = level;
+
+        if (++offsetCounter[index] >= settings.offsetLength)
+        {
+            offsetAmp[index] = offsetPeak[index];
+            offsetPeak[index] = 0.0f;
+
+            if (maskCounter[index] < settings.maskLength && ! isTriggering[index])
+            {
+                isTriggering[index] = true;
+                hasFired = true;
+                maskCounter[index] = 0;
+                isRunCounted[index] = true;
+            }
+            else if (! isRunCounted[index])
+            {
+                //a hit that rings on completes the offset again and again, but it's only one would-be trigger
+                ++numMasked;
+                isRunCounted[index] = true;
+            }
+
+            offsetCounter[index] = 0;
+        }
+    }
+    else
+    {
+        offsetCounter[index] = 0;
+        isRunCounted[index] = false;
+    }
+
+    if (++maskCounter[index] >= settings.maskLength)
+    {
+        isTriggering[index] = false;
+        maskCounter[index] = 0;
+    }
+
+    return hasFired;
+}
+
+void DetectorStates::skipQuietRun(int i, int numSamples, const DetectorSettings& settings) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    auto index = static_cast<size_t>(i);
+
+    offsetCounter[index] = 0;
+    isRunCounted[index] = false;
+
+    //the mask counter wraps back to zero every time it reaches the mask length
+    auto& mask = maskCounter[index];
+    mask += numSamples;
+
+    if (mask >= settings.maskLength)
+    {
+        auto firstWrap = juce::jmax(1, settings.maskLength - (mask - numSamples));
+
+        mask = (numSamples - firstWrap) % juce::jmax(1, settings.maskLength);
+        isTriggering[index] = false;
+    }
+}
+
+//==============================================================================
+void TransientDetector::prepare(int maximumBlockSize, int maximumWindowLength)
+{
+    mLevels.setSize(maxChannels, juce::jmax(1, maximumBlockSize));
+    mWindowedLevels.setSize(maxChannels, juce::jmax(1, maximumBlockSize));
+
+    for (auto& windowMaximum : mWindowMaxima)
+        windowMaximum.prepare(maximumWindowLength);
+
+    for (auto& fluxDetector : mFluxDetectors)
+        fluxDetector.prepare();
+
+    reset();
+}
+
+void TransientDetector::reset() noexcept
+{
+    mStates.reset();
+
+    for (auto& windowMaximum : mWindowMaxima)
+        windowMaximum.reset();
+
+    for (auto& fluxDetector : mFluxDetectors)
+        fluxDetector.reset();
+
+    mNumHits = 0;
+}
+
+void TransientDetector::setChannelMode(ChannelMode newMode) noexcept
+{
+    if (newMode != mMode)
+    {
+        mMode = newMode;
+        reset();
+    }
+}
+
+void TransientDetector::setMethod(Method newMethod) noexcept
+{
+    if (newMethod != mMethod)
+    {
+        mMethod = newMethod;
+        reset();
+    }
+}
+
+int TransientDetector::process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const DetectorSettings& settings) noexcept
+{
+    mNumHits = 0;
+    mNumMasked = 0;
+    mStates.numMasked = 0;
+
+    auto chunkSize = mLevels.getNumSamples();
+
+    if (buffer.getNumChannels() == 0 || chunkSize == 0)
+        return 0;
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+        processChunk(buffer, startSample + start, juce::jmin(chunkSize, numSamples - start), settings);
+
+    mNumMasked += mStates.numMasked;
+
+    return mNumHits;
+}
+
+void TransientDetector::processChunk(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const DetectorSettings& settings) noexcept
+{
+    auto numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+
+    if (mMethod == Method::spectralFlux)
+    {
+        //the spectrum needs the signed signal: each channel as it is, or linked channels averaged down to one
+        if (mMode == ChannelMode::perChannel)
+        {
+            mNumActiveStates = numChannels;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                runFluxDetector(channel, buffer.getReadPointer(channel, startSample), startSample, numSamples, settings);
+        }
+        else
+        {
+            mNumActiveStates = 1;
+
+            auto* mix = mLevels.getWritePointer(0);
+            auto channelGain = 1.0f / static_cast<float>(numChannels);
+
+            juce::FloatVectorOperations::copyWithMultiply(mix, buffer.getReadPointer(0, startSample), channelGain, numSamples);
+
+            for (int channel = 1; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::addWithMultiply(mix, buffer.getReadPointer(channel, startSample), channelGain, numSamples);
+
+            runFluxDetector(0, mix, startSample, numSamples, settings);
+        }
+
+        return;
+    }
+
+    //rectify the input into the level rows in one vectorised pass per channel
+    if (mMode == ChannelMode::perChannel)
+    {
+        mNumActiveStates = numChannels;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::abs(mLevels.getWritePointer(channel), buffer.getReadPointer(channel, startSample), numSamples);
+    }
+    else
+    {
+        mNumActiveStates = 1;
+
+        auto* levels = mLevels.getWritePointer(0);
+        auto* scratch = mLevels.getWritePointer(1);
+
+        juce::FloatVectorOperations::abs(levels, buffer.getReadPointer(0, startSample), numSamples);
+
+        for (int channel = 1; channel < numChannels; ++channel)
+        {
+            juce::FloatVectorOperations::abs(scratch, buffer.getReadPointer(channel, startSample), numSamples);
+
+            if (mMode == ChannelMode::linkedSum)
+                juce::FloatVectorOperations::add(levels, scratch, numSamples);
+            else
+                juce::FloatVectorOperations::max(levels, levels, scratch, numSamples);
+        }
+    }
+
+    runDetectors(startSample, numSamples, settings);
+}
+
+void TransientDetector::runDetectors(int startSample, int numSamples, const DetectorSettings& settings) noexcept
+{
+    auto isPerChannel = mMode == ChannelMode::perChannel;
+
+    std::array<int, maxChannels> loudChannels;
+    std::array<const float*, maxChannels> loudLevels, loudWindowed;
+    int numLoudChannels = 0;
+
+    for (int i = 0; i < mNumActiveStates; ++i)
+    {
+        auto* levels = mLevels.getReadPointer(i);
+        auto& windowMaximum = mWindowMaxima[static_cast<size_t>(i)];
+
+        //every window ending in this chunk is made of levels from the last window and the chunk itself, so
+        //if neither reaches the threshold nothing can fire, and the channel skips straight to the end of it
+        auto chunkMaximum = juce::FloatVectorOperations::findMaximum(levels, numSamples);
+
+        if (! (settings.threshold < windowMaximum.getMaximum()) && ! (settings.threshold < chunkMaximum))
+        {
+            mStates.skipQuietRun(i, numSamples, settings);
+            //any older levels the seed drops were under the threshold as well, so they can't change when a hit fires
+            windowMaximum.seed(levels, numSamples, settings.windowLength);
+            mStates.amplitude[static_cast<size_t>(i)] = windowMaximum.getMaximum();
+            continue;
+        }
+
+        //the sliding maximum has to run along each channel on its own...
+        auto* windowed = mWindowedLevels.getWritePointer(i);
+
+        for (int frame = 0; frame < numSamples; ++frame)
+            windowed[frame] = windowMaximum.push(levels[frame], settings.windowLength);
+
+        auto n = static_cast<size_t>(numLoudChannels++);
+        loudChannels[n] = i;
+        loudLevels[n] = levels;
+        loudWindowed[n] = windowed;
+    }
+
+    //...but the states are then advanced frame by frame across every loud channel together, so the
+    //hits come out in time order, whichever channel they're on
+    for (int frame = 0; frame < numSamples; ++frame)
+    {
+        for (size_t n = 0; n < static_cast<size_t>(numLoudChannels); ++n)
+        {
+            auto i = loudChannels[n];
+
+            if (mStates.processSample(i, loudLevels[n][frame], loudWindowed[n][frame], settings))
+                addHit(isPerChannel ? i : -1, startSample + frame, mStates.offsetAmp[static_cast<size_t>(i)]);
+        }
+    }
+}
+
+void TransientDetector::runFluxDetector(int detectorIndex, const float* signal, int startSample, int numSamples, const DetectorSettings& settings) noexcept
+{
+    auto& fluxDetector = mFluxDetectors[static_cast<size_t>(detectorIndex)];
+    auto channel = mMode == ChannelMode::perChannel ? detectorIndex : -1;
+
+    for (int sample = 0; sample < numSamples;)
+    {
+        sample += fluxDetector.pushSamples(signal + sample, numSamples - sample, settings.threshold, settings.maskLength);
+
+        //onsets are reported on the last sample of the hop that revealed them
+        if (fluxDetector.hasOnset())
+            addHit(channel, startSample + sample - 1, fluxDetector.getOnsetLevel());
+        else if (fluxDetector.wasMasked())
+            ++mNumMasked;
+    }
+}
+
+float TransientDetector::getAmplitude() const noexcept
+{
+    auto amplitude = 0.0f;
+
+    for (int i = 0; i < mNumActiveStates; ++i)
+    {
+        auto index = static_cast<size_t>(i);
+        amplitude = juce::jmax(amplitude, mMethod == Method::spectralFlux ? mFluxDetectors[index].getAmplitude()
+                                                                           : mStates.amplitude[index]);
+    }
+
+    return amplitude;
+}
+
+double TransientDetector::getFrameCostMicroseconds() const noexcept
+{
+    if (mMethod != Method::spectralFlux)
+        return 0.0;
+
+    auto total = 0.0;
+
+    for (int i = 0; i < mNumActiveStates; ++i)
+        total += mFluxDetectors[static_cast<size_t>(i)].getAverageFrameMicroseconds();
+
+    return total;
+}
+
+void TransientDetector::addHit(int channel, int sampleOffset, float amplitude) noexcept
+{
+    jassert(mNumHits < maxHitsPerBlock);
+
+    if (mNumHits < maxHitsPerBlock)
+        mHits[static_cast<size_t>(mNumHits++)] = { channel, sampleOffset, amplitude };
+}
@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    TransientDetector.h
+
+    Peak-over-threshold hit detection. The detector state lives in its own
+    struct and is advanced exactly once per frame, so the window, offset and
+    mask lengths mean the same thing whatever the channel count.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectralFluxDetector.h"
+#include "SlidingMaximum.h"
+
+//==============================================================================
+struct DetectorSettings
+{
+    float threshold = 1.0f;
+    int windowLength = 256;//how long a level keeps the amplitude up, so the offset count survives zero crossings
+    int offsetLength = 512;
+    int maskLength = 14000;
+};
+
+//==============================================================================
+/**
+    The state of every detector channel, kept as one array per field so that
+    all channels are advanced together, frame by frame, without hopping
+    between structs. Each frame's update branches on the threshold, offset and
+    mask, so the channels are stepped in a loop rather than in SIMD lanes.
+*/
+struct DetectorStates
+{
+    static constexpr int size = 8;
+
+    void reset() noexcept;
+
+    //advances channel i by one frame, given the loudest level in the window ending on it.
+    //returns true if a hit fires on this frame.
+    bool processSample(int i, float level, float windowMaximum, const DetectorSettings& settings) noexcept;
+
+    //advances channel i over a run of frames that can't fire, because no window over them reaches the threshold
+    void skipQuietRun(int i, int numSamples, const DetectorSettings& settings) noexcept;
+
+    std::array<float, size> amplitude{};//loudest level in the window ending on the last frame
+
+    std::array<float, size> offsetPeak{};
+    std::array<float, size> offsetAmp{};//loudest level between crossing the threshold and firing
+    std::array<int, size> offsetCounter{};
+
+    std::array<int, size> maskCounter{};
+    std::array<bool, size> isTriggering{};
+    std::array<bool, size> isRunCounted{};//whether the current run over the threshold has fired or been counted as masked
+
+    int numMasked = 0;//would-be hits held back by the mask, one per run over the threshold, drained by the detector after every block
+};
+
+//==============================================================================
+/**
+*/
+class TransientDetector
+{
+public:
+    //==============================================================================
+    enum class ChannelMode
+    {
+        linkedMax = 0,//one detector fed with the loudest channel
+        linkedSum,//one detector fed with the sum of all channels
+        perChannel//an independent detector for every channel
+    };
+
+    enum class Method
+    {
+        peak = 0,//the level has to cross the threshold
+        spectralFlux//the spectrum has to jump above its recent average
+    };
+
+    struct Hit
+    {
+        int channel;//-1 when the detectors are linked
+        int sampleOffset;
+        float amplitude;
+    };
+
+    static constexpr int maxChannels = DetectorStates::size;
+    static constexpr int maxHitsPerBlock = 256;
+
+    //==============================================================================
+    //allocates the level buffers and amplitude windows. call from prepareToPlay(), never from the audio thread.
+    void prepare(int maximumBlockSize, int maximumWindowLength);
+
+    void reset() noexcept;
+    void setChannelMode(ChannelMode newMode) noexcept;
+    void setMethod(Method newMethod) noexcept;
+
+    //runs the detectors over part of a block, frame by frame. returns the number of hits found,
+    //with offsets from the start of the buffer.
+    int process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const DetectorSettings& settings) noexcept;
+
+    const Hit& getHit(int index) const noexcept             { return mHits[static_cast<size_t>(index)]; }
+
+    //how many hits the mask held back during the last process() call
+    int getNumMasked() const noexcept                       { return mNumMasked; }
+
+    //the loudest window amplitude across all detectors, for metering
+    float getAmplitude() const noexcept;
+
+    //how long the spectral flux engine spends per hop, summed over the active detectors
+    double getFrameCostMicroseconds() const noexcept;
+
+private:
+    //==============================================================================
+    void processChunk(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const DetectorSettings& settings) noexcept;
+    void runDetectors(int startSample, int numSamples, const DetectorSettings& settings) noexcept;
+    void runFluxDetector(int detectorIndex, const float* signal, int startSample, int numSamples, const DetectorSettings& settings) noexcept;
+    void addHit(int channel, int sampleOffset, float amplitude) noexcept;
+
+    DetectorStates mStates;
+    std::array<SlidingMaximum, maxChannels> mWindowMaxima;
+    std::array<SpectralFluxDetector, maxChannels> mFluxDetectors;
+    juce::AudioBuffer<float> mLevels;//rectified (or, for spectral flux, mixed) input, one row per detector
+    juce::AudioBuffer<float> mWindowedLevels;//the window maximum ending on each frame, one row per detector
+    ChannelMode mMode = ChannelMode::linkedMax;
+    Method mMethod = Method::peak;
+    int mNumActiveStates = 1;
+
+    std::array<Hit, maxHitsPerBlock> mHits;
+    int mNumHits = 0;
+    int mNumMasked = 0;
+};
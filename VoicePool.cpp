@@ -0,0 +1,298 @@
+/*
+  ==============================================================================
+
+    VoicePool.cpp
+
+  ==============================================================================
+*/
+
+#include "VoicePool.h"
+
+//==============================================================================
+void DrumVoice::start(const DrumSample& sample, float gain, double playbackRatio, int startDelay, int outputChannel, int slot,
+                      int startPosition, juce::uint32 startOrder) noexcept
+{
+    mSample = &sample;
+    mPosition = static_cast<double>(juce::jlimit(0, juce::jmax(0, sample.getNumSamples() - 1), startPosition));
+    mIncrement = playbackRatio;
+    mGain = gain;
+    mStartDelay = juce::jmax(0, startDelay);
+    mOutputChannel = outputChannel;
+    mSlot = slot;
+    mStartOrder = startOrder;
+
+    mFadeDelay = 0;
+    mFadeSamplesLeft = -1;
+    mFadeGain = 1.0f;
+    mFadeStep = 0.0f;
+}
+
+void DrumVoice::startFadeOut(int fadeDelay, int fadeLengthInSamples) noexcept
+{
+    if (! isActive() || isFadingOut())
+        return;
+
+    //a voice that hasn't sounded yet has nothing to fade
+    if (mStartDelay > fadeDelay)
+    {
+        stop();
+        return;
+    }
+
+    mFadeDelay = juce::jmax(0, fadeDelay - mStartDelay);
+    mFadeSamplesLeft = juce::jmax(1, fadeLengthInSamples);
+    mFadeGain = 1.0f;
+    mFadeStep = 1.0f / static_cast<float>(mFadeSamplesLeft);
+}
+
+void DrumVoice::stop() noexcept
+{
+    mSample = nullptr;
+    mFadeSamplesLeft = -1;
+}
+
+float DrumVoice::getEstimatedLevel() const noexcept
+{
+    if (mSample == nullptr)
+        return 0.0f;
+
+    auto progress = static_cast<float>(mPosition / static_cast<double>(mSample->getNumSamples()));
+
+    return mGain * mFadeGain * juce::jmax(0.0f, 1.0f - progress);
+}
+
+bool DrumVoice::render(juce::AudioBuffer<float>& output, int startSample, int numSamples) noexcept
+{
+    if (mSample == nullptr)
+        return false;
+
+    //hold off until the sample position where the hit was detected
+    if (mStartDelay > 0)
+    {
+        auto numToSkip = juce::jmin(mStartDelay, numSamples);
+
+        mStartDelay -= numToSkip;
+        startSample += numToSkip;
+        numSamples -= numToSkip;
+
+        if (numSamples == 0)
+            return true;
+    }
+
+    const auto& source = mSample->getBuffer();
+    auto sourceLength = source.getNumSamples();
+    auto numSourceChannels = source.getNumChannels();
+
+    auto firstChannel = mOutputChannel >= 0 ? mOutputChannel : 0;
+    auto endChannel = mOutputChannel >= 0 ? juce::jmin(mOutputChannel + 1, output.getNumChannels()) : output.getNumChannels();
+
+    if (firstChannel >= endChannel)
+    {
+        stop();
+        return false;
+    }
+
+    //plain copy when the sample already runs at the host rate and isn't being faded out
+    if (mIncrement == 1.0 && ! isFadingOut())
+    {
+        auto position = static_cast<int>(mPosition);
+        auto numToCopy = juce::jmin(numSamples, sourceLength - position);
+
+        for (int channel = firstChannel; channel < endChannel; ++channel)
+            output.addFrom(channel, startSample, source, channel % numSourceChannels, position, numToCopy, mGain);
+
+        mPosition += numToCopy;
+
+        if (position + numToCopy >= sourceLength)
+        {
+            stop();
+            return false;
+        }
+
+        return true;
+    }
+
+    //otherwise step through with linear interpolation, applying the steal fade as we go
+    auto endPosition = mPosition;
+    auto endFadeGain = mFadeGain;
+    auto endFadeDelay = mFadeDelay;
+    auto endFadeSamplesLeft = mFadeSamplesLeft;
+
+    for (int channel = firstChannel; channel < endChannel; ++channel)
+    {
+        auto* out = output.getWritePointer(channel, startSample);
+        auto* in = source.getReadPointer(channel % numSourceChannels);
+
+        auto position = mPosition;
+        auto fadeGain = mFadeGain;
+        auto fadeDelay = mFadeDelay;
+        auto fadeSamplesLeft = mFadeSamplesLeft;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto index = static_cast<int>(position);
+
+            if (index >= sourceLength || fadeSamplesLeft == 0)
+                break;
+
+            auto alpha = static_cast<float>(position - index);
+            auto next = index + 1 < sourceLength ? in[index + 1] : 0.0f;
+
+            out[i] += (in[index] + alpha * (next - in[index])) * mGain * fadeGain;
+
+            position += mIncrement;
+
+            if (fadeDelay > 0)
+            {
+                --fadeDelay;
+            }
+            else if (fadeSamplesLeft > 0)
+            {
+                fadeGain -= mFadeStep;
+                --fadeSamplesLeft;
+            }
+        }
+
+        endPosition = position;
+        endFadeGain = fadeGain;
+        endFadeDelay = fadeDelay;
+        endFadeSamplesLeft = fadeSamplesLeft;
+    }
+
+    mPosition = endPosition;
+    mFadeGain = endFadeGain;
+    mFadeDelay = endFadeDelay;
+    mFadeSamplesLeft = endFadeSamplesLeft;
+
+    if (static_cast<int>(mPosition) >= sourceLength || mFadeSamplesLeft == 0)
+    {
+        stop();
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+void VoicePool::prepare(double sampleRate)
+{
+    mSampleRate = sampleRate;
+    mStealFadeLength = juce::jmax(1, static_cast<int>(sampleRate * 0.002));//2ms fade on stolen voices
+
+    //the extra voices give stolen hits somewhere to fade out while the new hit starts
+    mVoices.clear();
+    mVoices.resize(static_cast<size_t>(maxVoices * 2));
+}
+
+void VoicePool::setPolyphony(int numVoices) noexcept
+{
+    mPolyphony = juce::jlimit(1, maxVoices, numVoices);
+}
+
+//==============================================================================
+void VoicePool::startVoice(const DrumSample& sample, float gain, int sampleOffset, int outputChannel, int slot, int startPosition) noexcept
+{
+    if (mVoices.empty())
+        return;
+
+    int numSounding = 0;
+
+    for (auto& voice : mVoices)
+        if (voice.isActive() && ! voice.isFadingOut())
+            ++numSounding;
+
+    DrumVoice* victim = nullptr;
+
+    if (numSounding >= mPolyphony)
+    {
+        if (mStealingPolicy == StealingPolicy::ignoreNew)
+            return;
+
+        victim = findVoiceToSteal();
+
+        if (victim != nullptr)
+            victim->startFadeOut(sampleOffset, mStealFadeLength);
+    }
+
+    auto* voice = findFreeVoice();
+
+    //every slot is busy with fading tails as well, so cut the stolen voice instead
+    if (voice == nullptr)
+        voice = victim != nullptr ? victim : &mVoices.front();
+
+    voice->start(sample, gain, sample.getSampleRate() / mSampleRate, sampleOffset, outputChannel, slot, startPosition, mNextStartOrder++);
+}
+
+void VoicePool::stopAllVoices() noexcept
+{
+    for (auto& voice : mVoices)
+        voice.stop();
+}
+
+void VoicePool::fadeOutAllVoices() noexcept
+{
+    for (auto& voice : mVoices)
+        voice.startFadeOut(0, mStealFadeLength);
+}
+
+void VoicePool::fadeOutSlot(int slot) noexcept
+{
+    for (auto& voice : mVoices)
+        if (voice.isActive() && voice.getSlot() == slot)
+            voice.startFadeOut(0, mStealFadeLength);
+}
+
+void VoicePool::renderNextBlock(juce::AudioBuffer<float>& output, int startSample, int numSamples) noexcept
+{
+    for (auto& voice : mVoices)
+        if (voice.isActive())
+            voice.render(output, startSample, numSamples);
+}
+
+int VoicePool::getNumActiveVoices() const noexcept
+{
+    int numActive = 0;
+
+    for (auto& voice : mVoices)
+        if (voice.isActive())
+            ++numActive;
+
+    return numActive;
+}
+
+//==============================================================================
+DrumVoice* VoicePool::findVoiceToSteal() noexcept
+{
+    DrumVoice* best = nullptr;
+
+    for (auto& voice : mVoices)
+    {
+        if (! voice.isActive() || voice.isFadingOut())
+            continue;
+
+        if (best == nullptr)
+        {
+            best = &voice;
+        }
+        else if (mStealingPolicy == StealingPolicy::quietest)
+        {
+            if (voice.getEstimatedLevel() < best->getEstimatedLevel())
+                best = &voice;
+        }
+        else if (mNextStartOrder - voice.getStartOrder() > mNextStartOrder - best->getStartOrder())
+        {
+            best = &voice;//oldest, allowing for the counter wrapping round
+        }
+    }
+
+    return best;
+}
+
+DrumVoice* VoicePool::findFreeVoice() noexcept
+{
+    for (auto& voice : mVoices)
+        if (! voice.isActive())
+            return &voice;
+
+    return nullptr;
+}
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    VoicePool.h
+
+    A fixed set of sample voices, allocated up front in prepareToPlay(), so
+    that overlapping hits can ring out without cutting each other off.
+    Nothing in here locks or allocates once the pool has been prepared.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DrumSample.h"
+
+//==============================================================================
+/**
+*/
+class DrumVoice
+{
+public:
+    //==============================================================================
+    //startDelay is the number of samples into the next rendered block at which the hit begins.
+    //outputChannel restricts the voice to one channel, or -1 to play on all of them.
+    //slot is the kit slot the sample came from, so a reload can fade out just that slot's voices.
+    //startPosition is where in the sample playback begins, so the hit can skip its leading silence.
+    void start(const DrumSample& sample, float gain, double playbackRatio, int startDelay, int outputChannel, int slot,
+               int startPosition, juce::uint32 startOrder) noexcept;
+    void startFadeOut(int fadeDelay, int fadeLengthInSamples) noexcept;
+    void stop() noexcept;
+
+    //adds this voice into the output. returns false once the voice has finished.
+    bool render(juce::AudioBuffer<float>& output, int startSample, int numSamples) noexcept;
+
+    //==============================================================================
+    bool isActive() const noexcept                  { return mSample != nullptr; }
+    bool isFadingOut() const noexcept               { return mFadeSamplesLeft >= 0; }
+    juce::uint32 getStartOrder() const noexcept     { return mStartOrder; }
+    int getSlot() const noexcept                    { return mSlot; }
+
+    //a rough guess at how loud the voice still is, used when picking one to steal
+    float getEstimatedLevel() const noexcept;
+
+private:
+    //==============================================================================
+    const DrumSample* mSample = nullptr;
+    double mPosition = 0.0;
+    double mIncrement = 1.0;
+    float mGain = 0.0f;
+    int mStartDelay = 0;
+    int mOutputChannel = -1;
+    int mSlot = 0;
+    juce::uint32 mStartOrder = 0;
+
+    int mFadeDelay = 0;
+    int mFadeSamplesLeft = -1;
+    float mFadeGain = 1.0f;
+    float mFadeStep = 0.0f;
+};
+
+//==============================================================================
+/**
+*/
+class VoicePool
+{
+public:
+    //==============================================================================
+    enum class StealingPolicy
+    {
+        oldest = 0,
+        quietest,
+        ignoreNew
+    };
+
+    static constexpr int maxVoices = 32;
+
+    //==============================================================================
+    //allocates every voice. call from prepareToPlay(), never from the audio thread.
+    void prepare(double sampleRate);
+
+    void setPolyphony(int numVoices) noexcept;
+    void setStealingPolicy(StealingPolicy policy) noexcept          { mStealingPolicy = policy; }
+
+    //==============================================================================
+    //sampleOffset is the position inside the block about to be rendered where the hit lands
+    void startVoice(const DrumSample& sample, float gain, int sampleOffset, int outputChannel = -1, int slot = 0, int startPosition = 0) noexcept;
+    void stopAllVoices() noexcept;
+
+    //gives every voice the short steal fade, after which none of them will touch its sample again
+    void fadeOutAllVoices() noexcept;
+    void fadeOutSlot(int slot) noexcept;
+    int getFadeLength() const noexcept                              { return mStealFadeLength; }
+
+    void renderNextBlock(juce::AudioBuffer<float>& output, int startSample, int numSamples) noexcept;
+
+    int getNumActiveVoices() const noexcept;
+
+private:
+    //==============================================================================
+    DrumVoice* findVoiceToSteal() noexcept;
+    DrumVoice* findFreeVoice() noexcept;
+
+    std::vector<DrumVoice> mVoices;
+
+    double mSampleRate = 44100.0;
+    int mPolyphony = 8;
+    int mStealFadeLength = 64;
+    StealingPolicy mStealingPolicy = StealingPolicy::oldest;
+    juce::uint32 mNextStartOrder = 0;
+};